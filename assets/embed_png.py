@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# Decodes a png into raw RGBA pixels and writes them out as a C++ header, so the game doesn't
+# have to find and decode its sprites every time it starts (see assets/meson.build).
+#
+# usage: embed_png.py INPUT.png OUTPUT.hpp NAME
+#
+# Only does what our assets need: 8 bit or less per channel, no interlacing. It's plain python
+# so the build doesn't need anything meson doesn't already.
+
+import struct
+import sys
+import zlib
+
+
+def read_chunks(data):
+    if data[:8] != b'\x89PNG\r\n\x1a\n':
+        raise ValueError('not a png')
+
+    pos = 8
+    while pos < len(data):
+        length, kind = struct.unpack('>I4s', data[pos:pos + 8])
+        yield kind, data[pos + 8:pos + 8 + length]
+        pos += length + 12
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    if pa <= pb and pa <= pc:
+        return a
+    return b if pb <= pc else c
+
+
+def unfilter(raw, height, stride, bpp):
+    rows = []
+    prev = bytearray(stride)
+    pos = 0
+
+    for _ in range(height):
+        kind = raw[pos]
+        row = bytearray(raw[pos + 1:pos + 1 + stride])
+        pos += stride + 1
+
+        for i in range(stride):
+            left = row[i - bpp] if i >= bpp else 0
+            if kind == 1:
+                row[i] = (row[i] + left) & 0xFF
+            elif kind == 2:
+                row[i] = (row[i] + prev[i]) & 0xFF
+            elif kind == 3:
+                row[i] = (row[i] + ((left + prev[i]) >> 1)) & 0xFF
+            elif kind == 4:
+                upLeft = prev[i - bpp] if i >= bpp else 0
+                row[i] = (row[i] + paeth(left, prev[i], upLeft)) & 0xFF
+            elif kind != 0:
+                raise ValueError(f'unknown filter type {kind}')
+
+        rows.append(row)
+        prev = row
+
+    return rows
+
+
+# Pulls the samples out of a row, for bit depths below 8
+def samples(row, depth, count):
+    if depth == 8:
+        return row[:count]
+    perByte = 8 // depth
+    mask = (1 << depth) - 1
+    return [(row[i // perByte] >> (8 - depth * (i % perByte + 1))) & mask for i in range(count)]
+
+
+def decode(data):
+    chunks = list(read_chunks(data))
+    header = next(body for kind, body in chunks if kind == b'IHDR')
+    width, height, depth, colour, _, _, interlace = struct.unpack('>IIBBBBB', header)
+
+    if depth > 8 or interlace != 0:
+        raise ValueError('only non interlaced pngs with up to 8 bits per channel are supported')
+
+    channels = { 0: 1, 2: 3, 3: 1, 4: 2, 6: 4 }[colour]
+    palette = b''.join(body for kind, body in chunks if kind == b'PLTE')
+    alpha = b''.join(body for kind, body in chunks if kind == b'tRNS')
+    raw = zlib.decompress(b''.join(body for kind, body in chunks if kind == b'IDAT'))
+
+    stride = (width * channels * depth + 7) // 8
+    rows = unfilter(raw, height, stride, max(1, channels * depth // 8))
+
+    pixels = bytearray()
+    for row in rows:
+        s = samples(row, depth, width * channels)
+        for x in range(width):
+            if colour == 3:
+                i = s[x]
+                pixels += palette[i * 3:i * 3 + 3]
+                pixels.append(alpha[i] if i < len(alpha) else 0xFF)
+            elif colour == 6:
+                pixels += bytes(s[x * 4:x * 4 + 4])
+            elif colour == 2:
+                pixels += bytes(s[x * 3:x * 3 + 3])
+                pixels.append(0xFF)
+            else:
+                # Greyscale, with or without alpha, scaled up to 8 bits
+                grey = s[x * channels] * 255 // ((1 << depth) - 1)
+                pixels += bytes([grey, grey, grey])
+                pixels.append(s[x * 2 + 1] if colour == 4 else 0xFF)
+
+    return width, height, pixels
+
+
+def main():
+    inPath, outPath, name = sys.argv[1:4]
+    with open(inPath, 'rb') as f:
+        width, height, pixels = decode(f.read())
+
+    lines = [
+        '#pragma once',
+        '',
+        f'// Generated from {inPath.split("/")[-1]} by assets/embed_png.py, don\'t edit.',
+        '// RGBA, one byte per channel, rows top to bottom (i.e. SDL_PIXELFORMAT_RGBA32). Inline so every',
+        '// file that includes this shares the one copy.',
+        '',
+        f'const int {name}_WIDTH = {width};',
+        f'const int {name}_HEIGHT = {height};',
+        f'alignas(4) inline const unsigned char {name}_PIXELS[] = {{',
+    ]
+    for i in range(0, len(pixels), 32):
+        lines.append('    ' + ','.join(str(b) for b in pixels[i:i + 32]) + ',')
+    lines.append('};')
+
+    with open(outPath, 'w') as f:
+        f.write('\n'.join(lines) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -1,42 +1,63 @@
 #pragma once
 
 // An abstract class that represents an ai that plays solitaire
-#include "src/cards.hpp"
-#include <array>
+#include "src/board.hpp"
+#include "src/moves.hpp"
+#include "thinking.hpp"
+#include <cstdint>
+#include <format>
 #include <optional>
-#include <variant>
-#include <vector>
+#include <string>
 
-enum CardSource {
-    CS_Pile,
-    CS_Playfield,
-    CS_Aces,
+// How long an ai can think about one move. The clock starts when nextMove is called. Either
+// limit can be left out, and if both are, the ai does the same as it would with no budget.
+struct SearchBudget {
+    std::optional<double> seconds;
+    std::optional<uint64_t> nodes;
 };
 
-struct MoveToStack {
-    CardSource source;
-    std::pair<int, int> fromCoord;
-    int toStackId;
-};
-
-struct MoveToAces {
-    CardSource source;
-    std::pair<int, int> fromCoord;
-    int toAcesId;
-};
-
-struct CyclePile {};
-
-typedef std::variant<MoveToStack, MoveToAces, CyclePile> SolitaireMove;
+inline std::string describe(const SearchBudget& budget) {
+    if (budget.seconds && budget.nodes) {
+        return std::format("{}ms or {} nodes", *budget.seconds * 1e3, *budget.nodes);
+    } else if (budget.seconds) {
+        return std::format("{}ms", *budget.seconds * 1e3);
+    } else if (budget.nodes) {
+        return std::format("{} nodes", *budget.nodes);
+    } else {
+        return "no limit";
+    }
+}
 
 class SolitaireAI {
 public:
-    // Returns what move it thinks it should make given the state of the board
-    virtual std::optional<SolitaireMove> nextMove(
-        const std::array<std::vector<Card>, 7>& playfield,
-        const std::vector<Card>& pile,
-        const std::array<std::vector<Card>, 4>& aces
-    ) = 0;
+    // Returns what move it thinks it should make given the state of the board.
+    //
+    // The whole board is passed in, but an ai that plays fair should only look at what a player
+    // could see: the face up cards on the playfield, the pile and the aces.
+    virtual std::optional<SolitaireMove> nextMove(const Board& board) = 0;
+
+    // Same as above, but the ai should use up the budget and return the best move it has found
+    // when it runs out. Ais that don't search ignore the budget.
+    virtual std::optional<SolitaireMove> nextMove(const Board& board, const SearchBudget& budget) {
+        (void)budget;
+        return nextMove(board);
+    }
+
+    // Starts thinking about a move, a slice at a time (see thinking.hpp). Search ais keep
+    // improving their answer for as long as they're resumed. The rest just do nextMove in one go.
+    virtual Thinking think(const Board& board) {
+        co_return nextMove(board);
+    }
+
+    // Forgets anything it remembers about the game it's been playing, because the next board
+    // it's given won't be from that game
+    virtual void forget() {}
+
+    // Whether it always makes the same move from the same board, so playing a position out more
+    // than once tells us nothing new
+    virtual bool deterministic() const {
+        return false;
+    }
 
     virtual ~SolitaireAI() {}
 };
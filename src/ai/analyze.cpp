@@ -0,0 +1,91 @@
+#include "analyze.hpp"
+#include "benchmark.hpp"
+#include "../counters.hpp"
+#include "../notation.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include <format>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+template <typename R>
+std::string analyze_position(SolitaireAI& ai, const std::string& line, const AnalyzeOptions& options) {
+    Board board = board_from_text(line, options.rules);
+    WorkCounters& counters = thread_counters();
+
+    ai.forget();
+    uint64_t nodesBefore = counters.nodesSearched;
+    Timer timer;
+    std::optional<SolitaireMove> move = options.play.budget ? ai.nextMove(board, *options.play.budget) : ai.nextMove(board);
+    double seconds = timer.elapsed();
+    uint64_t nodes = counters.nodesSearched - nodesBefore;
+
+    std::string winChance = "-";
+    if (options.playouts > 0) {
+        int wins = 0;
+
+        for (int i = 0; i < options.playouts; i++) {
+            Board playout(board);
+            if (move) {
+                playout.apply_move<R>(*move);
+            }
+
+            wins += playout.is_solved() || play_game<R>(ai, playout, options.play).has_value();
+        }
+
+        winChance = std::format("{:.3f}", static_cast<double>(wins) / options.playouts);
+    }
+
+    return std::format("{} {} {} {:.0f}", move ? move_to_text(*move) : "none", winChance, nodes, seconds * 1e6);
+}
+
+void analyze(const AiFactory& makeAi, const AnalyzeOptions& options, std::istream& in, std::ostream& out) {
+    TRACE_SCOPE("analyze");
+
+    int workers = worker_count(options.threads);
+    std::vector<std::unique_ptr<SolitaireAI>> ais;
+    for (int i = 0; i < workers; i++) {
+        ais.push_back(makeAi());
+    }
+
+    if (options.playouts > 1 && ais.front()->deterministic()) {
+        throw std::runtime_error("This ai plays a position the same way every time, so more than one playout tells you nothing");
+    }
+
+    std::vector<std::string> lines;
+    std::vector<std::string> results;
+
+    while (in) {
+        // Waits for the first line, then takes whatever else has already arrived. Fed a line at a
+        // time, each answer comes back straight away instead of waiting for a whole batch.
+        lines.clear();
+        for (std::string line; (int)lines.size() < options.batchSize && std::getline(in, line);) {
+            lines.push_back(std::move(line));
+            if (in.rdbuf()->in_avail() <= 0) {
+                break;
+            }
+        }
+
+        results.assign(lines.size(), "");
+
+        with_rules(options.rules, [&]<typename R>() {
+            parallel_for(lines.size(), workers, [&](int worker, int i) {
+                try {
+                    results[i] = analyze_position<R>(*ais[worker], lines[i], options);
+                } catch (const std::exception& e) {
+                    results[i] = std::format("error {}", e.what());
+                }
+            });
+        });
+
+        for (const std::string& result : results) {
+            out << result << '\n';
+        }
+        out.flush();
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <iosfwd>
+#include <optional>
+#include "src/ai/benchmark.hpp"
+#include "src/ai/factory.hpp"
+#include "src/rules.hpp"
+
+struct AnalyzeOptions {
+    RuleSet rules;
+    // 0 means one per hardware thread
+    int threads = 0;
+    // If this is more than 0, the ai plays the position out this many times after its move, to
+    // estimate the chance of winning from there. More than 1 is only any use if the ai makes
+    // random choices, and it's an error for one that doesn't (like bea).
+    int playouts = 0;
+    // How the ai plays. Safe moves are only made in playouts, the positions are taken as given.
+    PlayOptions play;
+    // The most positions read in before being shared out between the workers. A batch is cut
+    // short when no more input has arrived yet.
+    int batchSize = 1024;
+};
+
+// Reads boards (see notation.hpp), one per line, and writes a line for each one in the same
+// order, like
+//
+//     MOVE WIN_CHANCE NODES MICROSECONDS
+//
+// MOVE is "none" if the ai has nothing to do, and WIN_CHANCE is "-" without playouts. A line that
+// isn't a board gets "error" and the reason instead. Output is written a batch at a time, and a
+// batch is only as big as what's waiting to be read, so it can be used as a filter on a stream
+// that never ends, or to answer one line at a time.
+void analyze(const AiFactory& makeAi, const AnalyzeOptions& options, std::istream& in, std::ostream& out);
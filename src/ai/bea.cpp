@@ -0,0 +1,331 @@
+#include "bea.hpp"
+#include "utils.hpp"
+#include "../counters.hpp"
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include <algorithm>
+#include <vector>
+
+const int FACE_DOWN_SCORE = -20;
+const int ACES_SCORE = 10;
+const int MOBILITY_SCORE = 1;
+// With a budget we go as deep as the budget allows, but no game is longer than this
+const int MAX_BUDGETED_DEPTH = 1000;
+// Roughly how many moves there are from a position, for sizing the tree
+const size_t BRANCHING_ESTIMATE = 10;
+
+Bea::Bea(BeamOptions options) :
+    options(options),
+    treeCap(options.maxTreeNodes > 0 ? options.maxTreeNodes : options.width * options.depth * BRANCHING_ESTIMATE)
+{}
+
+int face_down_cards(const Board& board) {
+    int count = 0;
+
+    for (const CardStack& stack : board.playfield) {
+        for (const Card& c : stack) {
+            count += c.upturned ? 0 : 1;
+        }
+    }
+
+    return count;
+}
+
+// The part of the score that doesn't depend on what can be moved
+int static_score(const Board& board) {
+    int score = FACE_DOWN_SCORE * face_down_cards(board);
+
+    for (const CardStack& acesPile : board.aces) {
+        score += ACES_SCORE * acesPile.size();
+    }
+
+    return score;
+}
+
+template <typename R>
+int evaluate(const Board& board, std::pmr::memory_resource* memory) {
+    return static_score(board) + MOBILITY_SCORE * (int)possible_moves<R>(board, memory).size();
+}
+
+std::optional<SolitaireMove> Bea::nextMove(const Board& board) {
+    TRACE_SCOPE("Bea::nextMove");
+
+    Thinking thinking = search(board, options.depth);
+    while (thinking.resume()) {}
+    return thinking.best();
+}
+
+std::optional<SolitaireMove> Bea::nextMove(const Board& board, const SearchBudget& budget) {
+    if (!budget.seconds && !budget.nodes) {
+        return nextMove(board);
+    }
+
+    TRACE_SCOPE("Bea::nextMove");
+
+    Timer timer;
+    auto outOfBudget = [&] {
+        return (budget.nodes && nodes >= *budget.nodes) || (budget.seconds && timer.elapsed() >= *budget.seconds);
+    };
+
+    // Keep going until the budget's gone, but not before we have a move to give
+    Thinking thinking = search(board, MAX_BUDGETED_DEPTH);
+    while (thinking.resume() && (!thinking.best() || !outOfBudget())) {}
+    return thinking.best();
+}
+
+void Bea::forget() {
+    played.clear();
+    tree.clear();
+}
+
+// Only with a time budget does it ever play differently, and then not by much
+bool Bea::deterministic() const {
+    return true;
+}
+
+Thinking Bea::think(const Board& board) {
+    return search(board, MAX_BUDGETED_DEPTH);
+}
+
+Thinking Bea::search(const Board& board, int maxDepth) {
+    return with_rules(board.rules, [&]<typename R>() { return search<R>(board, maxDepth); });
+}
+
+// A child of a position in the beam that we've scored but not kept yet. Its board isn't held on
+// to, so the ones that make the cut are built again from their parent, which is cheaper than
+// keeping a board for every child.
+struct Candidate {
+    int score;
+    int parent;
+    SolitaireMove move;
+    SolitaireMove firstMove;
+    // Reveals can be the best move, but the search doesn't go past them
+    bool revealed;
+};
+
+void Bea::forget_old_positions() {
+    std::erase_if(tree, [&](const auto& entry) { return entry.second.turn != turn; });
+
+    // A position can be kept without its children, and then it has to be expanded again
+    for (auto& [hash, node] : tree) {
+        bool missingChildren = std::any_of(node.children.begin(), node.children.end(),
+            [&](const Child& child) { return !child.revealed && !tree.contains(child.hash); });
+
+        if (missingChildren) {
+            node.children.clear();
+            node.expanded = false;
+        }
+    }
+}
+
+template <typename R>
+void Bea::make_move(Board& board, const SolitaireMove& move) const {
+    board.apply_move<R>(move);
+    if (options.safeMoves) {
+        board.apply_safe_moves<R>();
+    }
+}
+
+template <typename R>
+void Bea::expand(const Board& board, uint64_t hash, std::vector<Child>& children) {
+    children.clear();
+
+    if (auto it = tree.find(hash); it != tree.end() && it->second.expanded) {
+        it->second.turn = turn;
+        children = it->second.children;
+        for (const Child& child : children) {
+            if (!child.revealed) {
+                tree.at(child.hash).turn = turn;
+            }
+        }
+        thread_counters().nodesReused += children.size();
+        return;
+    }
+
+    MoveList moves = possible_moves<R>(board, &pool);
+    int faceDown = face_down_cards(board);
+    bool unseenStock = !board.stock.empty() && board.redeals == 0;
+
+    for (const SolitaireMove& move : moves) {
+        Board child(board, &pool);
+        make_move<R>(child, move);
+        nodes++;
+        thread_counters().nodesSearched++;
+
+        uint64_t childHash = child.state_hash();
+        bool revealed = face_down_cards(child) < faceDown
+            || (unseenStock && std::holds_alternative<CyclePile>(move));
+
+        if (revealed) {
+            // Everything that depends on the new card is left out: the safe moves it might make
+            // possible, and the moves it might make possible after that, which we count as the
+            // same as before
+            std::optional<Board> shown;
+            if (options.safeMoves) {
+                shown.emplace(board, &pool);
+                shown->apply_move<R>(move);
+            }
+            const Board& visible = shown ? *shown : child;
+
+            int score = static_score(visible) + MOBILITY_SCORE * (int)moves.size();
+            children.push_back(Child { move, childHash, child.canonical_hash(), score, visible.is_solved(), true });
+        } else if (auto it = tree.find(childHash); it != tree.end()) {
+            it->second.turn = turn;
+            children.push_back(Child { move, childHash, it->second.key, it->second.score, it->second.solved, false });
+        } else {
+            children.push_back(Child { move, childHash, child.canonical_hash(), evaluate<R>(child, &pool), child.is_solved(), false });
+        }
+    }
+
+    // Once the tree is full we carry on without it, so it never costs more than treeCap positions
+    if (tree.size() + children.size() + 1 > treeCap) {
+        return;
+    }
+
+    TreeNode& node = tree[hash];
+    node.turn = turn;
+    node.expanded = true;
+    node.children = children;
+
+    for (const Child& c : children) {
+        if (c.revealed) {
+            continue;
+        }
+
+        auto [it, inserted] = tree.try_emplace(c.hash);
+        if (inserted) {
+            it->second.key = c.key;
+            it->second.score = c.score;
+            it->second.solved = c.solved;
+        }
+        it->second.turn = turn;
+    }
+}
+
+template <typename R>
+Thinking Bea::search(const Board& board, int maxDepth) {
+    // However the search ends, even if it's abandoned part way through, tidy up the tree
+    OnExit tidyUp([this] { forget_old_positions(); });
+
+    uint64_t rootHash = board.state_hash();
+    uint64_t rootKey = board.canonical_hash();
+    played.insert(rootKey);
+
+    // Last turn's search will have been through this position if it's one of its descendants,
+    // and then we can pick up where it left off. Otherwise it's no use to us.
+    if (!tree.contains(rootHash)) {
+        tree.clear();
+    }
+    turn++;
+
+    seen.clear();
+    seen.insert(rootKey);
+
+    std::vector<Child> children;
+    // Kept for when every move leads somewhere we've played (see the end)
+    std::vector<Child> rootChildren;
+
+    std::pmr::vector<Board> beam(&pool);
+    std::vector<uint64_t> beamHashes;
+    std::vector<SolitaireMove> firstMoves;
+    beam.emplace_back(board, &pool);
+    beamHashes.push_back(rootHash);
+    firstMoves.push_back(CyclePile {});
+
+    std::vector<Candidate> candidates;
+    std::optional<SolitaireMove> best;
+    int bestScore = 0;
+    nodes = 0;
+    uint64_t nextPause = options.sliceNodes;
+
+    for (int depth = 0; depth < maxDepth && !beam.empty(); depth++) {
+        candidates.clear();
+
+        for (int parent = 0; parent < (int)beam.size(); parent++) {
+            expand<R>(beam[parent], beamHashes[parent], children);
+            if (depth == 0) {
+                rootChildren = children;
+            }
+
+            for (const Child& child : children) {
+                // A reveal can't have been played or seen already without knowing the card, so
+                // it isn't checked against them
+                if (!child.revealed) {
+                    if (played.contains(child.key) || seen.contains(child.key)) {
+                        continue;
+                    }
+                    if (seen.size() < treeCap) {
+                        seen.insert(child.key);
+                    }
+                }
+
+                const SolitaireMove& firstMove = depth == 0 ? child.move : firstMoves[parent];
+
+                if (child.solved) {
+                    co_return firstMove;
+                }
+
+                // Only counts once we've seen every move from the start, so the first move we
+                // hand out is at least the best one a move ahead
+                if (depth > 0 && child.score > bestScore) {
+                    best = firstMove;
+                    bestScore = child.score;
+                }
+
+                candidates.push_back(Candidate { child.score, parent, child.move, firstMove, child.revealed });
+            }
+
+            if (nodes >= nextPause && best) {
+                nextPause = nodes + options.sliceNodes;
+                co_yield best;
+            }
+        }
+
+        auto byScore = [](const Candidate& a, const Candidate& b) { return a.score > b.score; };
+
+        if (depth == 0 && !candidates.empty()) {
+            const Candidate& top = *std::min_element(candidates.begin(), candidates.end(), byScore);
+            best = top.firstMove;
+            bestScore = top.score;
+        }
+
+        // Only the best `width` of the ones we can see past get to carry on
+        std::erase_if(candidates, [](const Candidate& c) { return c.revealed; });
+        int kept = std::min<int>(options.width, candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + kept, candidates.end(), byScore);
+        candidates.resize(kept);
+
+        std::pmr::vector<Board> next(&pool);
+        next.reserve(kept);
+        std::vector<uint64_t> nextHashes;
+        std::vector<SolitaireMove> nextFirstMoves;
+
+        for (const Candidate& c : candidates) {
+            next.emplace_back(beam[c.parent], &pool);
+            make_move<R>(next.back(), c.move);
+            nextHashes.push_back(next.back().state_hash());
+            nextFirstMoves.push_back(c.firstMove);
+        }
+
+        beam = std::move(next);
+        beamHashes = std::move(nextHashes);
+        firstMoves = std::move(nextFirstMoves);
+    }
+
+    // Every move leads somewhere we've already played. Going round in circles still beats giving
+    // up while there are moves left, so take the best of them (preferring any we haven't played).
+    if (!best) {
+        bool bestPlayed = true;
+        for (const Child& child : rootChildren) {
+            bool childPlayed = played.contains(child.key);
+
+            if (!best || (bestPlayed && !childPlayed) || (bestPlayed == childPlayed && child.score > bestScore)) {
+                best = child.move;
+                bestScore = child.score;
+                bestPlayed = childPlayed;
+            }
+        }
+    }
+
+    co_return best;
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include "ai.hpp"
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+struct BeamOptions {
+    // How many positions to keep at each depth
+    int width = 32;
+    // How many moves ahead to look
+    int depth = 8;
+    // How many positions to look at in each slice of think() before pausing
+    int sliceNodes = 500;
+    // Whether to make the safe moves (see Board::apply_safe_moves) after every move it looks at.
+    // This should match what the game does, or the next turn's board won't be one it's seen.
+    bool safeMoves = false;
+    // The most positions to remember, both in the search tree and for spotting repeats. Once
+    // that's full, new positions are still scored but not remembered. 0 means width x depth x a
+    // typical number of moves per position, so memory goes with the size of the beam rather than
+    // with how long it's left to think.
+    size_t maxTreeNodes = 0;
+};
+
+// A solitaire bot that does a beam search: it looks `depth` moves ahead, but at each depth it
+// only keeps the `width` positions that look best, so the beam never holds more than about
+// `width` boards however hard the deal is. The positions it remembers (to carry the search over
+// to the next turn, and to skip repeats) are capped at `maxTreeNodes`, which by default is a small
+// multiple of width x depth, so the memory stays fixed however long it thinks.
+//
+// Given a budget, or when it's thinking a slice at a time, it ignores `depth` and keeps going
+// deeper until it's told to stop.
+//
+// It plays fair: it tries moves out on a copy of the board, but a line ends as soon as a move turns
+// over a face down card or deals a card from the stock it hasn't seen yet, and that move is scored
+// on what it does to the cards we can see. Positions are judged on how many cards are still face
+// down, how many are on the aces, and how many moves there are to make.
+class Bea : public SolitaireAI {
+public:
+    Bea(BeamOptions options = {});
+
+    std::optional<SolitaireMove> nextMove(const Board& board) override;
+    std::optional<SolitaireMove> nextMove(const Board& board, const SearchBudget& budget) override;
+    Thinking think(const Board& board) override;
+    void forget() override;
+    bool deterministic() const override;
+
+private:
+    // One move out of a position, and what we know about where it goes
+    struct Child {
+        SolitaireMove move;
+        uint64_t hash;
+        uint64_t key;
+        int score;
+        bool solved;
+        // Whether the move turns over a card we couldn't see. Where it goes from there depends on
+        // what that card is, so the search stops at it and it's scored without looking.
+        bool revealed;
+    };
+
+    // A position we've looked at, keyed by its state hash in `tree`
+    struct TreeNode {
+        // The position's canonical_hash, which is what we use to spot the same position again.
+        // The tree itself has to use state_hash, since the moves in it only work on one exact board.
+        uint64_t key = 0;
+        int score = 0;
+        bool solved = false;
+        // Whether `children` has been filled in yet
+        bool expanded = false;
+        // Only the children that weren't reveals have nodes of their own
+        std::vector<Child> children;
+        // The last turn this was part of the search
+        uint32_t turn = 0;
+    };
+
+    // The search itself, which pauses every options.sliceNodes positions
+    template <typename R>
+    Thinking search(const Board& board, int maxDepth);
+    Thinking search(const Board& board, int maxDepth);
+    // Finds and scores the children of the position, unless they're already in the tree. They're
+    // added to the tree if there's room for them.
+    template <typename R>
+    void expand(const Board& board, uint64_t hash, std::vector<Child>& children);
+    template <typename R>
+    void make_move(Board& board, const SolitaireMove& move) const;
+    // Throws away everything that wasn't part of this turn's search
+    void forget_old_positions();
+
+    BeamOptions options;
+    // Every position we've scored, and the moves out of the ones we've expanded. The next board
+    // we're given is almost always one of the positions we looked at last turn, so most of this
+    // turn's search has already been done. After each turn we keep only what that search used,
+    // which is everything below the new position. Never more than treeCap positions.
+    std::unordered_map<uint64_t, TreeNode> tree;
+    size_t treeCap;
+    uint32_t turn = 0;
+    // Positions looked at so far in the current search
+    uint64_t nodes = 0;
+    // Every position looked at so far this turn, so each one is only kept once (by canonical_hash).
+    // Stops growing at treeCap, after which repeats can get through.
+    std::unordered_set<uint64_t> seen;
+    // Every position we've actually played this game, so we don't end up going round in circles
+    // (by canonical_hash)
+    std::unordered_set<uint64_t> played;
+    std::pmr::unsynchronized_pool_resource pool;
+};
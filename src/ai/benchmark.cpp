@@ -1,37 +1,294 @@
 #include "benchmark.hpp"
-#include "../game.hpp"
+#include "../board.hpp"
+#include "../counters.hpp"
+#include "../trace.hpp"
 #include "../utils.hpp"
 #include "ai.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <format>
+#include <fstream>
+#include <memory_resource>
+#include <mutex>
 #include <print>
+#include <stdexcept>
+#include <thread>
 
-const int MAX_TURNS = 400;
-const int GAMES = 10000;
+// Early stopping only looks every this many games, and never before MIN_STOPPING_GAMES
+const int STOP_CHECK_EVERY = 50;
+const int MIN_STOPPING_GAMES = 200;
+// z for a two sided 95% interval
+const double Z_95 = 1.959964;
+// Error rates for the sequential test against a baseline (false "better"/"worse", and missed ones)
+const double SPRT_ALPHA = 0.05;
+const double SPRT_BETA = 0.05;
+// How close to the baseline counts as the same, if --precision doesn't say
+const double DEFAULT_BASELINE_MARGIN = 0.01;
 
-void benchmark(int draw, std::unique_ptr<SolitaireAI> ai) {
-    Game g(draw, std::move(ai));
-    int games = GAMES;
+struct GameOutcome {
+    bool done = false;
+    bool won = false;
+    int turns = 0;
+    float seconds = 0;
+};
+
+// What the workers share. Games finish out of order, and wins and losses don't take the same
+// time, so stopping on whatever happened to finish first would skew the win rate. Instead
+// stopping only ever looks at games 0 to settled, which are all done.
+struct BenchmarkRun {
+    std::vector<GameOutcome> outcomes;
+    std::atomic<int> nextGame = 0;
+    // Workers don't start any game past this. Only lowered when stopping early.
+    std::atomic<int> limit;
+
+    std::mutex mutex;
+    int settled = 0;
+    int settledWins = 0;
+    int nextCheck = MIN_STOPPING_GAMES;
+    // Why we stopped early, if we did
+    std::optional<std::string> stopReason;
+    // For the test against the baseline, the log likelihood ratios of "better" and "worse"
+    // against "the same"
+    double betterLlr = 0;
+    double worseLlr = 0;
+    // Where "the same" is for each of those tests: the baseline's rate if it's exact, or the top
+    // and bottom of its 95% interval if it was measured
+    double betterFrom = 0;
+    double worseFrom = 0;
+    bool betterRuledOut = false;
+    bool worseRuledOut = false;
+};
+
+// What one worker thread found out
+struct WorkerResult {
+    WorkCounters counters;
+    int gamesPlayed = 0;
+};
+
+struct Interval {
+    double low;
+    double high;
+};
+
+// The Wilson score interval, which unlike the usual p +- z * stderr behaves near 0% and 100%,
+// and win rates of a few percent are common here
+Interval wilson_interval(int wins, int games, double z) {
+    if (games == 0) {
+        return { 0, 1 };
+    }
+
+    double n = games;
+    double p = wins / n;
+    double centre = (p + z * z / (2 * n)) / (1 + z * z / n);
+    double halfWidth = z * std::sqrt(p * (1 - p) / n + z * z / (4 * n * n)) / (1 + z * z / n);
+    return { std::max(0.0, centre - halfWidth), std::min(1.0, centre + halfWidth) };
+}
+
+// Records the game, and decides whether we've seen enough. Called with the lock held.
+void settle(BenchmarkRun& run, const BenchmarkOptions& options) {
+    while (run.settled < (int)run.outcomes.size() && run.outcomes[run.settled].done) {
+        bool won = run.outcomes[run.settled].won;
+        run.settled++;
+        run.settledWins += won;
+
+        // Wald's sequential probability ratio test, run twice: "better by the margin" against
+        // "the same", and "worse by the margin" against "the same". Either can be looked at
+        // after every game without the error rates creeping up.
+        if (options.baseline) {
+            double margin = options.precision.value_or(DEFAULT_BASELINE_MARGIN);
+            double betterP0 = std::clamp(run.betterFrom, 1e-6, 1 - 1e-6);
+            double worseP0 = std::clamp(run.worseFrom, 1e-6, 1 - 1e-6);
+            double better = std::min(betterP0 + margin, 1 - 1e-6);
+            double worse = std::max(worseP0 - margin, 1e-6);
+            run.betterLlr += won ? std::log(better / betterP0) : std::log((1 - better) / (1 - betterP0));
+            run.worseLlr += won ? std::log(worse / worseP0) : std::log((1 - worse) / (1 - worseP0));
+        }
+    }
+
+    if (run.stopReason || run.settled < run.nextCheck) {
+        return;
+    }
+    run.nextCheck = run.settled + STOP_CHECK_EVERY;
+
+    if (options.baseline) {
+        double accept = std::log((1 - SPRT_BETA) / SPRT_ALPHA);
+        double reject = std::log(SPRT_BETA / (1 - SPRT_ALPHA));
+        double margin = options.precision.value_or(DEFAULT_BASELINE_MARGIN);
+
+        // Once a test has said "the same" it's done, and doesn't get to change its mind
+        if (!run.betterRuledOut && run.betterLlr >= accept) {
+            run.stopReason = std::format("better than {}", describe(*options.baseline));
+        } else if (!run.worseRuledOut && run.worseLlr >= accept) {
+            run.stopReason = std::format("worse than {}", describe(*options.baseline));
+        }
+
+        run.betterRuledOut |= run.betterLlr <= reject;
+        run.worseRuledOut |= run.worseLlr <= reject;
+
+        if (!run.stopReason && run.betterRuledOut && run.worseRuledOut) {
+            run.stopReason = std::format("within {:.2f}% of {}", 100 * margin, describe(*options.baseline));
+        }
+    }
+
+    if (!run.stopReason && options.precision) {
+        Interval interval = wilson_interval(run.settledWins, run.settled, Z_95);
+        if ((interval.high - interval.low) / 2 <= *options.precision) {
+            run.stopReason = std::format("win rate known to +-{:.2f}%", 100 * *options.precision);
+        }
+    }
+
+    if (run.stopReason) {
+        run.limit = run.settled;
+    }
+}
+
+template <typename R>
+void benchmark_worker(const AiFactory& makeAi, const BenchmarkOptions& options, BenchmarkRun& run, WorkerResult& result) {
+    std::unique_ptr<SolitaireAI> ai = makeAi();
+
+    // Every game's board is allocated from this, and it's all freed in one go when the game ends
+    std::vector<std::byte> arenaBuffer(GAME_ARENA_SIZE);
+    std::pmr::monotonic_buffer_resource arena(arenaBuffer.data(), arenaBuffer.size());
+
+    WorkCounters& counters = thread_counters();
+    counters = WorkCounters {};
+
+    for (int i = run.nextGame++; i < run.limit; i = run.nextGame++, arena.release()) {
+        TRACE_SCOPE("benchmark game");
+
+        Board board(options.rules, &arena);
+        board.deal(options.seed + i);
+        Timer t;
+
+        std::optional<int> turns = play_game<R>(*ai, board, options.play);
+        result.gamesPlayed++;
+
+        std::lock_guard lock(run.mutex);
+        run.outcomes[i] = GameOutcome { true, turns.has_value(), turns.value_or(0), static_cast<float>(t.elapsed()) };
+        settle(run, options);
+    }
+
+    result.counters = counters;
+}
+
+Baseline load_baseline(const std::string& path) {
+    std::ifstream in(path);
+    Baseline baseline;
+    unsigned int seed;
+    RuleSet rules;
+    int foundationReturn;
+
+    if (!(in >> baseline.wins >> baseline.games >> seed >> rules.draw >> rules.passes >> foundationReturn)
+        || baseline.games <= 0 || baseline.wins < 0 || baseline.wins > baseline.games) {
+        throw std::runtime_error(std::format(
+            "Couldn't read a baseline (\"wins games seed draw passes foundationReturn\", from --save-baseline) from \"{}\"", path));
+    }
+
+    rules.foundationReturn = foundationReturn;
+    baseline.rate = static_cast<double>(baseline.wins) / baseline.games;
+    baseline.seed = seed;
+    baseline.rules = rules;
+    return baseline;
+}
+
+void save_baseline(const std::string& path, const Baseline& baseline) {
+    std::ofstream out(path);
+    const RuleSet& rules = baseline.rules.value_or(RuleSet {});
+    out << baseline.wins << " " << baseline.games << " " << baseline.seed.value_or(0) << " "
+        << rules.draw << " " << rules.passes << " " << rules.foundationReturn << std::endl;
+
+    if (!out) {
+        throw std::runtime_error(std::format("Couldn't write the baseline to \"{}\"", path));
+    }
+}
+
+std::string describe(const Baseline& baseline) {
+    if (baseline.games == 0) {
+        return std::format("the baseline of {:.2f}%", 100 * baseline.rate);
+    }
+
+    Interval interval = wilson_interval(baseline.wins, baseline.games, Z_95);
+    return std::format("the baseline of {:.2f}% ({:.2f}% to {:.2f}% over {} games)",
+        100 * baseline.rate, 100 * interval.low, 100 * interval.high, baseline.games);
+}
+
+std::string describe(const PlayOptions& play) {
+    std::string text = play.budget ? std::format("{} per move", describe(*play.budget)) : "no budget";
+    return play.safeMoves ? text + ", safe moves made automatically" : text;
+}
+
+void print_counter(const char* name, uint64_t total, int games, double seconds) {
+    std::println("  {:<20} {:>14} total {:>12.1f} per game {:>14.0f} per second",
+        name, total, static_cast<double>(total) / games, static_cast<double>(total) / seconds);
+}
+
+void benchmark(const AiFactory& makeAi, const BenchmarkOptions& options) {
+    TRACE_SCOPE("benchmark");
+
+    int threadCount = options.threads > 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<WorkerResult> results(threadCount);
+    BenchmarkRun run;
+    run.outcomes.resize(options.games);
+    run.limit = options.games;
+
+    if (const std::optional<Baseline>& baseline = options.baseline) {
+        if (baseline->rules && *baseline->rules != options.rules) {
+            throw std::runtime_error(std::format("The baseline was measured with {}, so it can't be compared with {}",
+                describe(*baseline->rules), describe(options.rules)));
+        }
+
+        // A baseline that was only measured could be anywhere in its interval
+        Interval interval = baseline->games > 0 ? wilson_interval(baseline->wins, baseline->games, Z_95) : Interval { baseline->rate, baseline->rate };
+        run.betterFrom = interval.high;
+        run.worseFrom = interval.low;
+    }
+    Timer wallTimer;
+
+    with_rules(options.rules, [&]<typename R>() {
+        std::vector<std::jthread> workers;
+        for (int i = 0; i < threadCount; i++) {
+            workers.emplace_back(benchmark_worker<R>, std::cref(makeAi), std::cref(options), std::ref(run), std::ref(results[i]));
+        }
+    });
+
+    double wallTime = wallTimer.elapsed();
+
+    // Games that were already going when we stopped early still finish, but only the ones before
+    // the stopping point count towards the win rate
+    int games = run.stopReason ? run.limit.load() : options.games;
     int wins = 0;
     std::vector<int> turnCounts;
     std::vector<float> times;
+    WorkCounters counters;
+    int gamesPlayed = 0;
 
     for (int i = 0; i < games; i++) {
-        g.setup_game();
-        Timer t;
+        const GameOutcome& outcome = run.outcomes[i];
+        if (outcome.won) {
+            wins++;
+            turnCounts.push_back(outcome.turns);
+            times.push_back(outcome.seconds);
+        }
+    }
 
-        for (int turn = 0; turn < MAX_TURNS; turn++) {
-            g.run_ai();
+    for (const WorkerResult& r : results) {
+        counters += r.counters;
+        gamesPlayed += r.gamesPlayed;
+    }
 
-            if (g.is_solved()) {
-                float time = t.elapsed();
-                times.push_back(time);
-                turnCounts.push_back(turn + 1);
-                wins++;
-                break;
-            }
-        }
+    if (run.stopReason) {
+        std::println("stopped after {} of {} games: {}", games, options.games, *run.stopReason);
     }
 
     std::println("ai won {} out of {} games. (wr: {}%)", wins, games, 100 * static_cast<float>(wins) / static_cast<float>(games));
+    Interval interval = wilson_interval(wins, games, Z_95);
+    std::println("95% confidence interval: {:.2f}% to {:.2f}%", 100 * interval.low, 100 * interval.high);
+
+    if (options.saveBaseline) {
+        save_baseline(*options.saveBaseline, Baseline {
+            .rate = static_cast<double>(wins) / games, .wins = wins, .games = games, .seed = options.seed, .rules = options.rules });
+    }
 
     // For saving results to plot
     // I tried this but found the results weren't very interesting
@@ -69,4 +326,25 @@ void benchmark(int draw, std::unique_ptr<SolitaireAI> ai) {
         std::println("Average turn count: {}.", totalTurns / static_cast<float>(turnCounts.size()));
         std::println("Average time: {}s", totalTime / static_cast<float>(times.size()));
     }
+
+    // Rates are per second of wall clock time, so they go up with the thread count
+    std::println("\nWork done ({} threads, {:.2f}s, seed {}, {}):", threadCount, wallTime, options.seed, describe(options.rules));
+    if (options.play.budget || options.play.safeMoves) {
+        std::println("  ({})", describe(options.play));
+    }
+    print_counter("possible_moves calls", counters.possibleMovesCalls, gamesPlayed, wallTime);
+    print_counter("moves generated", counters.movesGenerated, gamesPlayed, wallTime);
+    print_counter("moves applied", counters.movesApplied, gamesPlayed, wallTime);
+    print_counter("pile cycles", counters.pileCycles, gamesPlayed, wallTime);
+    if (counters.safeMoves > 0) {
+        print_counter("safe moves", counters.safeMoves, gamesPlayed, wallTime);
+    }
+    if (counters.nodesSearched > 0) {
+        print_counter("nodes searched", counters.nodesSearched, gamesPlayed, wallTime);
+    }
+    if (counters.nodesReused > 0) {
+        print_counter("nodes reused", counters.nodesReused, gamesPlayed, wallTime);
+    }
+    std::println("  {:<20} {:>14.3f}s total {:>11.3f}us per call",
+        "time in nextMove", counters.nextMoveSeconds, counters.nextMoveSeconds * 1e6 / std::max<uint64_t>(counters.nextMoveCalls, 1));
 }
@@ -1,6 +1,99 @@
 #pragma once
 
-#include "src/ai/ai.hpp"
-#include <memory>
+#include "src/ai/factory.hpp"
+#include "src/counters.hpp"
+#include "src/rules.hpp"
+#include "src/utils.hpp"
+#include <optional>
+#include <string>
 
-void benchmark(int draw, std::unique_ptr<SolitaireAI> ai);
+const int MAX_TURNS = 400;
+// Plenty for one game's worth of board, so the arena never has to go to the heap
+const size_t GAME_ARENA_SIZE = 64 * 1024;
+
+// How an ai is made to play a game
+struct PlayOptions {
+    // If set, every move is made with this budget (see SearchBudget)
+    std::optional<SearchBudget> budget;
+    // If set, the safe moves (see Board::apply_safe_moves) are made for the ai after every move,
+    // so it doesn't have to spend turns on them
+    bool safeMoves = false;
+};
+
+std::string describe(const PlayOptions& play);
+
+// A win rate to compare against. Either given on the command line, in which case it's taken as
+// exact, or saved by an earlier run (see save_baseline), which is only a sample and so comes with
+// how it was measured.
+struct Baseline {
+    // From 0 to 1
+    double rate = 0;
+    // How many games the rate was measured over, or 0 if it was given exactly
+    int wins = 0;
+    int games = 0;
+    // The run that measured it, if there was one
+    std::optional<unsigned int> seed;
+    std::optional<RuleSet> rules;
+};
+
+std::string describe(const Baseline& baseline);
+
+struct BenchmarkOptions {
+    RuleSet rules;
+    int games = 10000;
+    // 0 means one per hardware thread
+    int threads = 0;
+    // Game i is dealt with seed + i, so two runs with the same seed play the same deals
+    unsigned int seed = 0;
+    PlayOptions play;
+
+    // Stop as soon as the 95% confidence interval of the win rate is this narrow either side
+    // (e.g. 0.005 for +-0.5%), rather than always playing every game
+    std::optional<double> precision;
+    // A win rate to compare against. The run stops as soon as a sequential test can say the ai is
+    // better, worse, or within `precision` (1% if that isn't set) of it. A measured baseline
+    // could be off itself, so "better" has to beat the top of its 95% interval, and "worse" be
+    // under the bottom of it. Throws if the baseline was measured under different rules.
+    std::optional<Baseline> baseline;
+    // Where to save the result, for comparing against later (see load_baseline)
+    std::optional<std::string> saveBaseline;
+};
+
+void benchmark(const AiFactory& makeAi, const BenchmarkOptions& options);
+
+// Baseline files are "wins games seed draw passes foundationReturn" on one line
+Baseline load_baseline(const std::string& path);
+void save_baseline(const std::string& path, const Baseline& baseline);
+
+// Lets the ai play the board until it wins or runs out of turns. Returns how many turns it took
+// to win, or nullopt if it didn't. The ai forgets whatever game it played before.
+template <typename R>
+std::optional<int> play_game(SolitaireAI& ai, Board& board, const PlayOptions& play = {}) {
+    WorkCounters& counters = thread_counters();
+    ai.forget();
+
+    if (play.safeMoves) {
+        board.apply_safe_moves<R>();
+    }
+
+    for (int turn = 0; turn < MAX_TURNS; turn++) {
+        Timer moveTimer;
+        std::optional<SolitaireMove> move = play.budget ? ai.nextMove(board, *play.budget) : ai.nextMove(board);
+        counters.nextMoveSeconds += moveTimer.elapsed();
+        counters.nextMoveCalls++;
+
+        if (move) {
+            board.apply_move<R>(*move);
+        }
+
+        if (play.safeMoves) {
+            board.apply_safe_moves<R>();
+        }
+
+        if (board.is_solved()) {
+            return turn + 1;
+        }
+    }
+
+    return std::nullopt;
+}
@@ -0,0 +1,144 @@
+#include "compare.hpp"
+#include "../board.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include "ai.hpp"
+#include "benchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <memory_resource>
+#include <print>
+
+// Everything one thread needs to play a deal with every ai
+struct CompareWorker {
+    std::vector<std::unique_ptr<SolitaireAI>> ais;
+    std::vector<double> seconds;
+    std::vector<std::byte> arenaBuffer = std::vector<std::byte>(GAME_ARENA_SIZE);
+    std::pmr::monotonic_buffer_resource arena { arenaBuffer.data(), arenaBuffer.size() };
+};
+
+// The two sided p value of McNemar's test, given how many deals only the first ai won and how
+// many only the second ai won. Deals they both won or both lost don't tell us anything.
+//
+// For small counts the chi squared approximation is bad, so we do the exact binomial test instead.
+double mcnemar_p(int onlyFirst, int onlySecond) {
+    int n = onlyFirst + onlySecond;
+    if (n == 0) {
+        return 1.0;
+    }
+
+    if (n < 25) {
+        // P(X <= min) for X ~ Binomial(n, 1/2), doubled
+        double pmf = std::pow(0.5, n);
+        double tail = 0;
+        for (int k = 0; k <= std::min(onlyFirst, onlySecond); k++) {
+            tail += pmf;
+            pmf *= static_cast<double>(n - k) / (k + 1);
+        }
+        return std::min(1.0, 2 * tail);
+    }
+
+    // With the continuity correction. This has one degree of freedom, so its tail is erfc(sqrt(x/2))
+    double d = std::abs(onlyFirst - onlySecond) - 1.0;
+    double chiSquared = d * d / n;
+    return std::erfc(std::sqrt(chiSquared / 2));
+}
+
+void compare_rules(const CompareOptions& options, const RuleSet& rules, std::vector<std::unique_ptr<CompareWorker>>& workers) {
+    TRACE_SCOPE("compare_rules");
+
+    int aiCount = options.ais.size();
+    // won[a][i] is whether ai a won deal i. Not vector<bool> since several threads write to it.
+    std::vector<std::vector<char>> won(aiCount, std::vector<char>(options.games));
+
+    for (std::unique_ptr<CompareWorker>& w : workers) {
+        std::fill(w->seconds.begin(), w->seconds.end(), 0.0);
+    }
+
+    with_rules(rules, [&]<typename R>() {
+        parallel_for(options.games, workers.size(), [&](int worker, int i) {
+            CompareWorker& w = *workers[worker];
+
+            // Dealt once, and every ai gets a copy
+            Board deal(rules, &w.arena);
+            deal.deal(options.seed + i);
+
+            for (int a = 0; a < aiCount; a++) {
+                Board board(deal, &w.arena);
+                Timer t;
+                won[a][i] = play_game<R>(*w.ais[a], board, options.play).has_value();
+                w.seconds[a] += t.elapsed();
+            }
+
+            w.arena.release();
+        });
+    });
+
+    std::println("{} ({} deals, seed {}, {}):", describe(rules), options.games, options.seed, describe(options.play));
+
+    for (int a = 0; a < aiCount; a++) {
+        int wins = std::count(won[a].begin(), won[a].end(), 1);
+        double seconds = 0;
+        for (std::unique_ptr<CompareWorker>& w : workers) {
+            seconds += w->seconds[a];
+        }
+
+        std::println("  {:<10} won {:>7} ({:>6.2f}%) {:>10.3f}ms per game",
+            options.ais[a].name, wins, 100.0 * wins / options.games, seconds * 1e3 / options.games);
+    }
+
+    // We're doing several tests at once, so each one has to clear a stricter bar (Bonferroni)
+    int pairs = aiCount * (aiCount - 1) / 2;
+    double alpha = 0.05 / std::max(pairs, 1);
+
+    for (int a = 0; a < aiCount; a++) {
+        for (int b = a + 1; b < aiCount; b++) {
+            int onlyA = 0, onlyB = 0, both = 0;
+            for (int i = 0; i < options.games; i++) {
+                onlyA += won[a][i] && !won[b][i];
+                onlyB += !won[a][i] && won[b][i];
+                both += won[a][i] && won[b][i];
+            }
+
+            const std::string& nameA = options.ais[a].name;
+            const std::string& nameB = options.ais[b].name;
+            double p = mcnemar_p(onlyA, onlyB);
+
+            std::println("  {} vs {}: only {} won {}, only {} won {}, both won {}",
+                nameA, nameB, nameA, onlyA, nameB, onlyB, both);
+
+            if (p < alpha) {
+                std::println("    p = {:.3g}, so {} is better", p, onlyA > onlyB ? nameA : nameB);
+            } else {
+                std::println("    p = {:.3g}, no significant difference (needs p < {:.3g})", p, alpha);
+            }
+        }
+    }
+}
+
+void compare(const CompareOptions& options) {
+    TRACE_SCOPE("compare");
+
+    std::vector<std::unique_ptr<CompareWorker>> workers;
+    for (int i = 0; i < worker_count(options.threads); i++) {
+        std::unique_ptr<CompareWorker> w = std::make_unique<CompareWorker>();
+        for (const ComparedAi& ai : options.ais) {
+            w->ais.push_back(ai.make());
+        }
+        w->seconds.resize(options.ais.size());
+        workers.push_back(std::move(w));
+    }
+
+    Timer timer;
+
+    for (size_t r = 0; r < options.ruleSets.size(); r++) {
+        if (r != 0) {
+            std::println("");
+        }
+        compare_rules(options, options.ruleSets[r], workers);
+    }
+
+    std::println("\ntook {:.2f}s using {} threads", timer.elapsed(), workers.size());
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "src/ai/benchmark.hpp"
+#include "src/ai/factory.hpp"
+#include "src/rules.hpp"
+#include <string>
+#include <vector>
+
+struct ComparedAi {
+    std::string name;
+    AiFactory make;
+};
+
+struct CompareOptions {
+    std::vector<ComparedAi> ais;
+    // Every ai plays every deal under each of these
+    std::vector<RuleSet> ruleSets;
+    int games = 10000;
+    // 0 means one per hardware thread
+    int threads = 0;
+    // Game i is dealt with seed + i, same as the benchmark
+    unsigned int seed = 0;
+    // How every ai plays every game
+    PlayOptions play;
+};
+
+// Plays every ai on the same deals, then compares them pairwise on those deals.
+//
+// Because the deals are shared, we can look only at the deals where one ai won and the other
+// lost, which cancels out the luck of the deal. That makes a difference between two ais show up
+// with far fewer games than comparing two separate benchmarks would.
+void compare(const CompareOptions& options);
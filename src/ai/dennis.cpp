@@ -4,120 +4,145 @@
 #include <print>
 #include <random>
 #include <algorithm>
+#include <format>
+#include <fstream>
 #include <stdexcept>
 #include <variant>
 
-Dennis::Dennis() :
+Dennis::Dennis(DennisParams params) :
+    params(params),
     rand(std::mt19937 { std::random_device{}() })
 {}
 
-const int VAL_FROM_ACES = 0;
-const int VAL_MOVE_NOT_UNCOVERING = 1;
-const int VAL_TO_ACES = 2;
-const int VAL_FROM_PILE = 3;
-const int VAL_MOVE_UNCOVERING = 4;
-
-int move_value(
-    const SolitaireMove& move,
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-) {
-    // The basic value of moves in this strategy is this (worst to best)
+Dennis::Dennis(DennisParams params, unsigned int seed) :
+    params(params),
+    rand(std::mt19937 { seed })
+{}
+
+const char* MOVE_KIND_NAMES[MOVE_KINDS] = {
+    "from_aces",
+    "move_not_uncovering",
+    "to_aces",
+    "from_pile",
+    "move_uncovering",
+};
+
+DennisParams load_dennis_params(const std::string& path) {
+    std::ifstream in(path);
+
+    if (!in) {
+        throw std::runtime_error(std::format("Couldn't open parameter file \"{}\"", path));
+    }
+
+    DennisParams params;
+    std::string name;
+    int value;
+
+    while (in >> name >> value) {
+        bool found = false;
+
+        for (int k = 0; k < MOVE_KINDS; k++) {
+            if (name == std::format("value_{}", MOVE_KIND_NAMES[k])) {
+                params.value[k] = value;
+                found = true;
+            } else if (name == std::format("cycle_{}", MOVE_KIND_NAMES[k])) {
+                params.cyclePercent[k] = value;
+                found = true;
+            }
+        }
+
+        if (!found) {
+            throw std::runtime_error(std::format("Unknown parameter \"{}\" in \"{}\"", name, path));
+        }
+    }
+
+    if (!in.eof()) {
+        throw std::runtime_error(std::format("Couldn't read parameter file \"{}\"", path));
+    }
+
+    return params;
+}
+
+void save_dennis_params(const std::string& path, const DennisParams& params) {
+    std::ofstream out(path);
+
+    if (!out) {
+        throw std::runtime_error(std::format("Couldn't open \"{}\" for writing", path));
+    }
+
+    for (int k = 0; k < MOVE_KINDS; k++) {
+        out << std::format("value_{} {}\n", MOVE_KIND_NAMES[k], params.value[k]);
+    }
+    for (int k = 0; k < MOVE_KINDS; k++) {
+        out << std::format("cycle_{} {}\n", MOVE_KIND_NAMES[k], params.cyclePercent[k]);
+    }
+}
+
+MoveKind move_kind(const SolitaireMove& move, const Board& board) {
+    // The kinds of moves in this strategy are these (worst to best, by default)
     //
     // 0 - move down from the aces
     // 1 - move playfield card, not uncovering new card
-    // 2 - move down from the pile
-    // 3 - move playfield card, uncovering new card
-    // 4 - move to aces
+    // 2 - move to aces
+    // 3 - move down from the pile
+    // 4 - move playfield card, uncovering new card
     //
     // We don't consider cycling the pile here. Since it can always be done, if it had a
     // value greater than 0 it would negate all moves below it. Instead, we give every move the
-    // chance to cycle the pile, and that chance changes based on the value of the best possible move.
+    // chance to cycle the pile, and that chance changes based on the kind of the best possible move.
     if (std::holds_alternative<MoveToStack>(move)) {
         MoveToStack m = std::get<MoveToStack>(move);
         if (m.source == CS_Aces) {
-            return VAL_FROM_ACES;
+            return MK_FromAces;
         } else if (m.source == CS_Playfield) {
-            const std::vector<Card>& fromStack = playfield.at(m.fromCoord.first);
+            const CardStack& fromStack = board.playfield.at(m.fromCoord.first);
             
             if (m.fromCoord.second == 0) {
                 // TODO: maybe consider checking if there is a king available anywhere
-                return VAL_MOVE_NOT_UNCOVERING; 
+                return MK_MoveNotUncovering; 
             } else if (fromStack.at(m.fromCoord.second - 1).upturned) {
-                return VAL_MOVE_NOT_UNCOVERING;
+                return MK_MoveNotUncovering;
             } else {
-                return VAL_MOVE_UNCOVERING;
+                return MK_MoveUncovering;
             }
         } else {
-            return VAL_FROM_PILE;
+            return MK_FromPile;
         }
     } else if (std::holds_alternative<MoveToAces>(move)) {
-        return VAL_TO_ACES;
+        return MK_ToAces;
     } else {
         throw std::runtime_error("Move cannot be evaluated."); 
     }
 }
 
-bool compare_moves(
-    const SolitaireMove& a,
-    const SolitaireMove& b,
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-) {
-    int valuea = move_value(a, playfield, pile, aces);
-    int valueb = move_value(b, playfield, pile, aces);
-    return valuea < valueb;
-}
-
-int cycle_pile_percentage(
-    const SolitaireMove& move,
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-) {
-    int val = move_value(move, playfield, pile, aces);
-
-    switch (val) {
-        case VAL_FROM_ACES:
-        case VAL_MOVE_NOT_UNCOVERING:
-            return 90;
-        case VAL_FROM_PILE:
-        case VAL_MOVE_UNCOVERING:
-        case VAL_TO_ACES:
-            return 0;
-        default:
-            return 100;
-    }
-}
+std::optional<SolitaireMove> Dennis::nextMove(const Board& board) {
+    MoveList moves = possible_moves(board, arena.reset());
 
-std::optional<SolitaireMove> Dennis::nextMove(
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-) {
-    std::vector<SolitaireMove> moves = possible_moves(playfield, pile, aces);
-
-    if (!moves.empty() && std::holds_alternative<CyclePile>(moves[0])) {
+    // If the rules let us cycle the pile right now, it'll be the first move
+    bool canCycle = !moves.empty() && std::holds_alternative<CyclePile>(moves[0]);
+    if (canCycle) {
         moves.erase(moves.begin());
     }
 
     std::sort(
         moves.begin(),
         moves.end(),
-        [&, playfield, pile, aces](const SolitaireMove& a, const SolitaireMove& b) {
-            return compare_moves(a, b, playfield, pile, aces);
+        [&](const SolitaireMove& a, const SolitaireMove& b) {
+            return params.value[move_kind(a, board)] < params.value[move_kind(b, board)];
         }
     );
 
     if (moves.empty()) {
-        return CyclePile {};
+        if (canCycle) {
+            return CyclePile {};
+        } else {
+            return std::nullopt;
+        }
     } else {
         const SolitaireMove& move = moves.back();
-        int cycleProb = cycle_pile_percentage(move, playfield, pile, aces);
+        int cycleProb = params.cyclePercent[move_kind(move, board)];
 
-        if (int r = (unsigned int) rand() % 100; r < cycleProb) {
+        if (int r = (unsigned int) rand() % 100; canCycle && r < cycleProb) {
             return CyclePile {};
         } else {
             return move;
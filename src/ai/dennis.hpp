@@ -1,8 +1,38 @@
 #pragma once
 
 #include "ai.hpp"
+#include "utils.hpp"
+#include <array>
 #include <optional>
 #include <random>
+#include <string>
+
+// The kinds of move Dennis tells apart
+enum MoveKind {
+    MK_FromAces,
+    MK_MoveNotUncovering,
+    MK_ToAces,
+    MK_FromPile,
+    MK_MoveUncovering,
+};
+
+const int MOVE_KINDS = 5;
+// Also the names used in parameter files
+extern const char* MOVE_KIND_NAMES[MOVE_KINDS];
+
+// Everything that decides how Dennis plays. The defaults are what I came up with by hand, and
+// `bs tune dennis` looks for better ones.
+struct DennisParams {
+    // How much Dennis likes each kind of move, indexed by MoveKind. It makes the one it likes most.
+    std::array<int, MOVE_KINDS> value = { 0, 1, 2, 3, 4 };
+    // The chance (out of 100) of cycling the pile instead, when the best move is of that kind
+    std::array<int, MOVE_KINDS> cyclePercent = { 90, 90, 0, 0, 0 };
+};
+
+// Parameter files are plain text with one "name value" pair per line, e.g. "value_to_aces 2".
+// Anything left out keeps its default.
+DennisParams load_dennis_params(const std::string& path);
+void save_dennis_params(const std::string& path, const DennisParams& params);
 
 // A naive solitaire bot that just makes whatever (non-frivolous) moves it can
 // Tries to reveal cards on the board. Failing that, tries to place cards from the pile.
@@ -12,14 +42,14 @@
 // My attempt to emulate a sort of "naive human" strategy without any kind of fancy lookahead.
 class Dennis : public SolitaireAI {
 public:
-    Dennis();
+    Dennis(DennisParams params = {});
+    // Same, but with the random choices seeded, so it plays a deal the same way every time
+    Dennis(DennisParams params, unsigned int seed);
 
-    std::optional<SolitaireMove> nextMove(
-        const std::array<std::vector<Card>, 7>& playfield,
-        const std::vector<Card>& pile,
-        const std::array<std::vector<Card>, 4>& aces
-    ) override;
+    std::optional<SolitaireMove> nextMove(const Board& board) override;
 
 private:
+    DennisParams params;
     std::mt19937 rand;
+    TurnArena arena;
 };
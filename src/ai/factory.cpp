@@ -0,0 +1,18 @@
+#include "factory.hpp"
+#include "bea.hpp"
+#include "dennis.hpp"
+#include "pippin.hpp"
+
+const char* AI_NAMES = "'dennis', 'pippin' and 'bea'";
+
+std::optional<AiFactory> ai_factory(std::string_view name, const AiOptions& options) {
+    if (name == "dennis") {
+        return [=] { return std::make_unique<Dennis>(options.dennis); };
+    } else if (name == "pippin") {
+        return [] { return std::make_unique<Pippin>(); };
+    } else if (name == "bea") {
+        return [=] { return std::make_unique<Bea>(options.beam); };
+    } else {
+        return std::nullopt;
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "ai.hpp"
+#include "bea.hpp"
+#include "dennis.hpp"
+#include <functional>
+#include <memory>
+#include <string_view>
+
+// Makes a new ai. Anything that runs games on several threads needs one ai per thread, so it
+// gets one of these instead of an ai.
+typedef std::function<std::unique_ptr<SolitaireAI>()> AiFactory;
+
+// Settings for the ais that have any. Each ai only looks at its own.
+struct AiOptions {
+    BeamOptions beam;
+    DennisParams dennis;
+};
+
+// Returns a factory for the ai with the given name, or nullopt if there's no ai by that name
+std::optional<AiFactory> ai_factory(std::string_view name, const AiOptions& options = {});
+
+// The names that ai_factory knows about, for usage messages
+extern const char* AI_NAMES;
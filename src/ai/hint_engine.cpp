@@ -0,0 +1,101 @@
+#include "hint_engine.hpp"
+#include "dennis.hpp"
+
+// The solver starts with this many nodes, and goes up by HINT_NODE_GROWTH times each round
+const uint64_t HINT_START_NODES = 20000;
+const uint64_t HINT_NODE_GROWTH = 4;
+// Past this the solver's seen set starts using a lot of memory, so we settle for Dennis's guess
+const uint64_t HINT_MAX_NODES = 2000000;
+
+HintEngine::HintEngine() : worker([this] { run(); }) {}
+
+HintEngine::~HintEngine() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+        cancelled = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void HintEngine::set_position(const Board& board) {
+    {
+        std::lock_guard lock(mutex);
+        pending.emplace(board);
+        generation++;
+        latest.reset();
+        cancelled = true;
+    }
+    wake.notify_one();
+}
+
+std::optional<Hint> HintEngine::hint() {
+    std::lock_guard lock(mutex);
+    return latest;
+}
+
+void HintEngine::publish(uint64_t forGeneration, const Hint& hint) {
+    std::lock_guard lock(mutex);
+    if (forGeneration == generation) {
+        latest = hint;
+    }
+}
+
+void HintEngine::run() {
+    Solver solver;
+    Dennis dennis;
+
+    while (true) {
+        std::optional<Board> board;
+        uint64_t current;
+
+        {
+            std::unique_lock lock(mutex);
+            wake.wait(lock, [&] { return stopping || pending.has_value(); });
+
+            if (stopping) {
+                return;
+            }
+
+            board = std::move(pending);
+            pending.reset();
+            current = generation;
+            cancelled = false;
+        }
+
+        uint64_t key = board->state_hash();
+        if (auto it = solved.find(key); it != solved.end()) {
+            publish(current, it->second);
+            continue;
+        }
+
+        // Something to show straight away, while the solver gets going
+        std::optional<SolitaireMove> guess = dennis.nextMove(*board);
+        if (guess) {
+            publish(current, Hint { *guess, SR_Unknown });
+        }
+
+        SolverOptions options;
+        options.cancelled = &cancelled;
+
+        for (options.nodeLimit = HINT_START_NODES; options.nodeLimit <= HINT_MAX_NODES && !cancelled; options.nodeLimit *= HINT_NODE_GROWTH) {
+            solver.set_options(options);
+            SolveStats stats = solver.solve(*board);
+
+            if (stats.result == SR_Unknown) {
+                continue;
+            }
+
+            // If nothing wins from here the player might still want to know what to try, so
+            // they get Dennis's guess
+            std::optional<SolitaireMove> move = stats.result == SR_Win ? stats.firstMove : guess;
+            if (move) {
+                Hint hint { *move, stats.result };
+                solved.emplace(key, hint);
+                publish(current, hint);
+            }
+            break;
+        }
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include "solver.hpp"
+
+struct Hint {
+    SolitaireMove move;
+    // SR_Win if the solver found a winning line starting with this move, SR_Loss if it proved
+    // there isn't one from here at all, and SR_Unknown if the move is just Dennis's best guess
+    SolveResult verdict;
+};
+
+// Works out hints for the human player on a background thread, so they're ready the moment
+// they're asked for.
+//
+// Whenever it's given a new position, it first asks Dennis (which takes microseconds), then
+// keeps running the solver with bigger and bigger node limits until it finds a winning line,
+// proves there isn't one, or hits HINT_MAX_NODES. Moving on to a new position cancels whatever
+// search was going. Answers the solver finished are remembered, so going back to a position
+// doesn't cost anything.
+//
+// The solver can see face down cards, so these hints know things the player doesn't.
+class HintEngine {
+public:
+    HintEngine();
+    ~HintEngine();
+
+    HintEngine(const HintEngine&) = delete;
+    HintEngine& operator=(const HintEngine&) = delete;
+
+    // Drops whatever it was working on and starts on this board. Only copies the board, the
+    // search is never waited for.
+    void set_position(const Board& board);
+    // The best hint for the last position given so far, if there is one yet
+    std::optional<Hint> hint();
+
+private:
+    void run();
+    // Makes this the hint, unless the position has changed since work on it started
+    void publish(uint64_t generation, const Hint& hint);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    // The position to work on next, if it's changed since the last one was picked up
+    std::optional<Board> pending;
+    // Counts the positions we've been given, so answers for old ones can be told apart
+    uint64_t generation = 0;
+    std::optional<Hint> latest;
+    bool stopping = false;
+
+    // Set to stop the solver when the position changes. Only touched by the worker otherwise.
+    std::atomic<bool> cancelled = false;
+    std::unordered_map<uint64_t, Hint> solved;
+
+    // Last so it starts after everything above is ready
+    std::thread worker;
+};
@@ -6,9 +6,5 @@ class Kiki : SolitaireAI {
 public:
     Kiki();
 
-    std::optional<SolitaireMove> nextMove(
-        const std::array<std::vector<Card>, 7>& playfield,
-        const std::vector<Card>& pile,
-        const std::array<std::vector<Card>, 4>& aces
-    ) override;
+    std::optional<SolitaireMove> nextMove(const Board& board) override;
 };
@@ -10,12 +10,8 @@ Pippin::Pippin():
     rand(std::mt19937 { std::random_device{}() })
 {}
 
-std::optional<SolitaireMove> Pippin::nextMove(
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-) {
-    std::vector<SolitaireMove> moves = possible_moves(playfield, pile, aces);
+std::optional<SolitaireMove> Pippin::nextMove(const Board& board) {
+    MoveList moves = possible_moves(board, arena.reset());
 
     for (int i = moves.size() - 1; i >= 0; i--) {
         auto m = moves[i];
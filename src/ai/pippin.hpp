@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ai.hpp"
+#include "utils.hpp"
 #include <optional>
 #include <random>
 #include <vector>
@@ -13,12 +14,9 @@ class Pippin : public SolitaireAI {
 public:
     Pippin();
 
-    std::optional<SolitaireMove> nextMove(
-        const std::array<std::vector<Card>, 7>& playfield,
-        const std::vector<Card>& pile,
-        const std::array<std::vector<Card>, 4>& aces
-    ) override;
+    std::optional<SolitaireMove> nextMove(const Board& board) override;
 
 private:
     std::mt19937 rand;
+    TurnArena arena;
 };
@@ -0,0 +1,238 @@
+#include "solution_cache.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <format>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// File layout (little endian, like the event traces):
+//
+// "BSSC" | version: u32 | record size: u32 | unused: u32
+// then CacheRecords one after another, until the end of the file
+
+const char CACHE_MAGIC[4] = { 'B', 'S', 'S', 'C' };
+const uint32_t CACHE_VERSION = 1;
+const size_t CACHE_HEADER_SIZE = 16;
+
+struct CacheHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t unused;
+};
+
+static_assert(sizeof(CacheHeader) == CACHE_HEADER_SIZE);
+
+// Everything that goes into an answer besides the position. An answer found with any of it
+// different could be wrong now, so it gets a different key and is never looked at again.
+uint64_t cache_key(const Board& board, const SolverOptions& options) {
+    uint64_t rules = board.rules.draw | board.rules.passes << 8 | (board.rules.foundationReturn ? 1 : 0) << 16;
+    uint64_t solver = static_cast<uint64_t>(SOLVER_VERSION) | static_cast<uint64_t>(options.safeMoves) << 16
+        | static_cast<uint64_t>(options.maxDepth) << 24;
+    return board.state_hash() ^ (rules * 0x9e3779b97f4a7c15) ^ (solver * 0xc2b2ae3d27d4eb4f);
+}
+
+uint32_t record_check(const CacheRecord& record) {
+    // FNV-1a over everything before the check
+    uint32_t h = 2166136261u;
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&record);
+    for (size_t i = 0; i < offsetof(CacheRecord, check); i++) {
+        h = (h ^ bytes[i]) * 16777619u;
+    }
+    // Never 0, so a run of zeros is never a valid record
+    return h | 1;
+}
+
+CacheRecord make_record(uint64_t key, uint64_t nodeLimit, const SolveStats& stats) {
+    CacheRecord record {};
+    record.key = key;
+    record.nodes = stats.nodes;
+    record.nodeLimit = static_cast<uint32_t>(std::min<uint64_t>(nodeLimit, UINT32_MAX));
+    record.result = stats.result;
+
+    if (stats.firstMove) {
+        const SolitaireMove& move = *stats.firstMove;
+        record.moveKind = move.index() + 1;
+
+        if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+            record.moveSource = m->source;
+            record.moveFromStack = m->fromCoord.first;
+            record.moveFromIndex = m->fromCoord.second;
+            record.moveTo = m->toStackId;
+        } else if (const MoveToAces* m = std::get_if<MoveToAces>(&move)) {
+            record.moveSource = m->source;
+            record.moveFromStack = m->fromCoord.first;
+            record.moveFromIndex = m->fromCoord.second;
+            record.moveTo = m->toAcesId;
+        }
+    }
+
+    record.check = record_check(record);
+    return record;
+}
+
+SolveStats stats_from_record(const CacheRecord& record) {
+    SolveStats stats;
+    stats.result = static_cast<SolveResult>(record.result);
+    stats.nodes = record.nodes;
+    stats.cached = true;
+
+    CardSource source = static_cast<CardSource>(record.moveSource);
+    std::pair<int, int> from = { record.moveFromStack, record.moveFromIndex };
+
+    switch (record.moveKind) {
+        case 1:
+            stats.firstMove = MoveToStack { source, from, record.moveTo };
+            break;
+        case 2:
+            stats.firstMove = MoveToAces { source, from, record.moveTo };
+            break;
+        case 3:
+            stats.firstMove = CyclePile {};
+            break;
+    }
+
+    return stats;
+}
+
+// Whether a is worth more to us than b, for the same position
+bool more_useful(const CacheRecord& a, const CacheRecord& b) {
+    bool aKnown = a.result != SR_Unknown;
+    bool bKnown = b.result != SR_Unknown;
+    return aKnown != bKnown ? aKnown : a.nodeLimit > b.nodeLimit;
+}
+
+SolutionCache::SolutionCache(const std::string& path) : path(path) {
+    fd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(std::format("Couldn't open solution cache \"{}\": {}", path, std::strerror(errno)));
+    }
+
+    // Whoever gets here first writes the header
+    flock(fd, LOCK_EX);
+    struct stat st;
+    fstat(fd, &st);
+    if (st.st_size == 0) {
+        CacheHeader header {};
+        std::memcpy(header.magic, CACHE_MAGIC, 4);
+        header.version = CACHE_VERSION;
+        header.recordSize = sizeof(CacheRecord);
+        if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+            flock(fd, LOCK_UN);
+            close(fd);
+            throw std::runtime_error(std::format("Couldn't write to solution cache \"{}\"", path));
+        }
+    }
+    flock(fd, LOCK_UN);
+
+    CacheHeader header;
+    bool valid = pread(fd, &header, sizeof(header), 0) == sizeof(header)
+        && std::memcmp(header.magic, CACHE_MAGIC, 4) == 0;
+
+    if (!valid || header.version != CACHE_VERSION || header.recordSize != sizeof(CacheRecord)) {
+        close(fd);
+        throw std::runtime_error(std::format("\"{}\" isn't a solution cache this version can read", path));
+    }
+
+    refresh();
+}
+
+SolutionCache::~SolutionCache() {
+    if (mapped != nullptr) {
+        munmap(const_cast<std::byte*>(mapped), mappedSize);
+    }
+    close(fd);
+}
+
+void SolutionCache::refresh() {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) == mappedSize) {
+        return;
+    }
+
+    if (mapped != nullptr) {
+        munmap(const_cast<std::byte*>(mapped), mappedSize);
+        mapped = nullptr;
+    }
+
+    mappedSize = st.st_size;
+    void* data = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+        mappedSize = 0;
+        throw std::runtime_error(std::format("Couldn't map solution cache \"{}\": {}", path, std::strerror(errno)));
+    }
+    mapped = static_cast<const std::byte*>(data);
+
+    size_t records = (mappedSize - CACHE_HEADER_SIZE) / sizeof(CacheRecord);
+    for (; recordsRead < records; recordsRead++) {
+        CacheRecord record;
+        std::memcpy(&record, mapped + CACHE_HEADER_SIZE + recordsRead * sizeof(CacheRecord), sizeof(record));
+
+        // Either someone crashed half way through writing it, or it's padding after one that did
+        if (record.check == record_check(record)) {
+            add_to_index(record);
+        }
+    }
+}
+
+void SolutionCache::add_to_index(const CacheRecord& record) {
+    auto [it, inserted] = index.try_emplace(record.key, record);
+    if (!inserted && more_useful(record, it->second)) {
+        it->second = record;
+    }
+}
+
+std::optional<SolveStats> SolutionCache::lookup(const Board& board, const SolverOptions& options) {
+    std::lock_guard lock(mutex);
+    uint64_t key = cache_key(board, options);
+    uint64_t nodeLimit = options.nodeLimit;
+
+    auto usable = [&](const CacheRecord& record) {
+        return record.result != SR_Unknown || record.nodeLimit >= nodeLimit;
+    };
+
+    auto it = index.find(key);
+    if (it == index.end() || !usable(it->second)) {
+        refresh();
+        it = index.find(key);
+    }
+
+    if (it == index.end() || !usable(it->second)) {
+        return std::nullopt;
+    }
+
+    return stats_from_record(it->second);
+}
+
+void SolutionCache::store(const Board& board, const SolverOptions& options, const SolveStats& stats) {
+    std::lock_guard lock(mutex);
+    CacheRecord record = make_record(cache_key(board, options), options.nodeLimit, stats);
+
+    flock(fd, LOCK_EX);
+
+    // If someone crashed part way through a record, pad it out so ours starts where a record should
+    struct stat st;
+    fstat(fd, &st);
+    size_t partial = (st.st_size - CACHE_HEADER_SIZE) % sizeof(CacheRecord);
+    std::byte padding[sizeof(CacheRecord)] {};
+    bool ok = partial == 0 || write(fd, padding, sizeof(CacheRecord) - partial) == static_cast<ssize_t>(sizeof(CacheRecord) - partial);
+    ok = ok && write(fd, &record, sizeof(record)) == sizeof(record);
+
+    flock(fd, LOCK_UN);
+
+    if (!ok) {
+        throw std::runtime_error(std::format("Couldn't write to solution cache \"{}\"", path));
+    }
+
+    add_to_index(record);
+}
+
+size_t SolutionCache::size() {
+    std::lock_guard lock(mutex);
+    refresh();
+    return index.size();
+}
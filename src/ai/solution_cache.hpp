@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include "solver.hpp"
+
+// What the solver found out about one position, as stored in the cache file. Always 32 bytes.
+struct CacheRecord {
+    // The position's state_hash mixed with the rules, SOLVER_VERSION and the solver options that
+    // can change the answer. Not the canonical hash, since the first move only makes sense on the
+    // exact board it was found for.
+    uint64_t key;
+    uint64_t nodes;
+    // The node limit the solver had. An SR_Unknown only tells us the position is too hard for
+    // that many nodes, and a bigger limit might get an answer.
+    uint32_t nodeLimit;
+    uint8_t result;
+    // 0 for no move, then 1 + the index into SolitaireMove
+    uint8_t moveKind;
+    uint8_t moveSource;
+    uint8_t moveFromStack;
+    uint8_t moveFromIndex;
+    uint8_t moveTo;
+    uint16_t unused;
+    // A hash of everything above, so a record that was only half written can be spotted
+    uint32_t check;
+};
+
+static_assert(sizeof(CacheRecord) == 32);
+
+// Solver answers kept on disk, so deals that have been solved before don't have to be solved again
+// in the next run.
+//
+// The file is only ever appended to, a whole record at a time while holding an flock on it, so
+// any number of processes (and threads) can use the same file at once. Each process maps the
+// file into memory when it opens it to read what's there, and looks again whenever it misses,
+// in case someone else has added to it since.
+//
+// POSIX only, like the rest of the benchmarking tools.
+class SolutionCache {
+public:
+    // Opens the cache, making it if it isn't there. Throws if it can't, or if the file isn't a cache.
+    explicit SolutionCache(const std::string& path);
+    ~SolutionCache();
+
+    SolutionCache(const SolutionCache&) = delete;
+    SolutionCache& operator=(const SolutionCache&) = delete;
+
+    // What the solver found for this board, if it's been solved before by this version of the
+    // solver with the same options, and with at least as many nodes (or solved for sure with any
+    // number)
+    std::optional<SolveStats> lookup(const Board& board, const SolverOptions& options);
+    void store(const Board& board, const SolverOptions& options, const SolveStats& stats);
+
+    // How many positions we know about
+    size_t size();
+
+private:
+    // Maps whatever has been added to the file since we last looked, and indexes it
+    void refresh();
+    void add_to_index(const CacheRecord& record);
+
+    std::string path;
+    int fd = -1;
+    const std::byte* mapped = nullptr;
+    size_t mappedSize = 0;
+    // How many records in the file are already in the index
+    size_t recordsRead = 0;
+    // The most useful record for each key
+    std::unordered_map<uint64_t, CacheRecord> index;
+    std::mutex mutex;
+};
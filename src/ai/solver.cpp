@@ -0,0 +1,254 @@
+#include "solver.hpp"
+#include "solution_cache.hpp"
+#include "utils.hpp"
+#include "../counters.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include <algorithm>
+#include <memory>
+#include <print>
+#include <variant>
+
+// Higher is tried first. Moves that make progress go first, so winnable deals get won quickly.
+int move_order(const SolitaireMove& move, const Board& board) {
+    if (std::holds_alternative<MoveToAces>(move)) {
+        return 5;
+    } else if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        if (m->source == CS_Aces) {
+            return 0;
+        } else if (m->source == CS_Pile) {
+            return 3;
+        }
+
+        // Playfield moves are only really useful if they turn over a card
+        int below = m->fromCoord.second - 1;
+        if (below >= 0 && !board.playfield.at(m->fromCoord.first).at(below).upturned) {
+            return 4;
+        }
+
+        return 2;
+    } else {
+        return 1;
+    }
+}
+
+SolveStats Solver::solve(const Board& board) {
+    TRACE_SCOPE("solve");
+
+    if (cache != nullptr) {
+        if (std::optional<SolveStats> cached = cache->lookup(board, options)) {
+            return *cached;
+        }
+    }
+
+    nodes = 0;
+    seen.clear();
+
+    SolveStats stats;
+    // The search makes its moves on this and takes them back
+    Board scratch(board, &pool);
+    stats.result = with_rules(board.rules, [&]<typename R>() {
+        return search<R>(scratch, 0, &stats.firstMove);
+    });
+    stats.nodes = nodes;
+    thread_counters().nodesSearched += nodes;
+
+    if (cache != nullptr) {
+        cache->store(board, options, stats);
+    }
+
+    return stats;
+}
+
+// Going through the stock one deal at a time makes for very long, very boring lines, so instead
+// the solver treats "cycle the pile some number of times, then play the top card" as one move.
+// Cycling doesn't touch the playfield or the aces, so this doesn't lose any winning lines.
+struct Line {
+    int cycles;
+    SolitaireMove move;
+};
+
+template <typename R>
+void possible_lines(const Board& board, std::pmr::memory_resource* memory, std::pmr::vector<Line>& lines) {
+    // All the empty stacks are the same, so only bother trying the first one
+    int firstEmpty = -1;
+    for (int i = 0; i < 7 && firstEmpty < 0; i++) {
+        if (board.playfield.at(i).empty()) {
+            firstEmpty = i;
+        }
+    }
+
+    auto worthTrying = [&](const SolitaireMove& move) {
+        const MoveToStack* m = std::get_if<MoveToStack>(&move);
+        return m == nullptr || !board.playfield.at(m->toStackId).empty() || m->toStackId == firstEmpty;
+    };
+
+    MoveList moves = possible_moves<R>(board, memory);
+    for (const SolitaireMove& move : moves) {
+        if (!std::holds_alternative<CyclePile>(move) && worthTrying(move)) {
+            lines.push_back(Line { 0, move });
+        }
+    }
+
+    // Deal through the stock until we either run out of passes or start seeing the same cards
+    // again, and see what we could play from the pile along the way. After the pile has been
+    // turned over twice, everything repeats.
+    Board sim(board, memory);
+    MoveList pileMoves(memory);
+
+    for (int cycles = 1; sim.can_cycle<R>(); cycles++) {
+        sim.deal_or_reset_stock<R>();
+
+        bool backToStart = sim.stock.size() == board.stock.size() && sim.pile.size() == board.pile.size();
+        if (backToStart || sim.redeals - board.redeals >= 2) {
+            break;
+        }
+
+        if (!sim.pile.empty()) {
+            pileMoves.clear();
+            possible_moves_for_card(sim.pile.back(), true, CS_Pile, { }, sim, pileMoves);
+
+            for (const SolitaireMove& move : pileMoves) {
+                if (worthTrying(move)) {
+                    lines.push_back(Line { cycles, move });
+                }
+            }
+        }
+    }
+}
+
+template <typename R>
+SolveResult Solver::search(Board& board, int depth, std::optional<SolitaireMove>* firstMove) {
+    if (board.is_solved()) {
+        return SR_Win;
+    }
+
+    if (++nodes > options.nodeLimit || depth > options.maxDepth) {
+        return SR_Unknown;
+    }
+
+    if (options.cancelled != nullptr && options.cancelled->load(std::memory_order_relaxed)) {
+        return SR_Unknown;
+    }
+
+    // Either we've been here before and it didn't work out, or we're going round in circles
+    if (!seen.insert(board.canonical_hash()).second) {
+        return SR_Loss;
+    }
+
+    std::pmr::vector<Line> lines(&pool);
+    possible_lines<R>(board, &pool, lines);
+
+    std::stable_sort(lines.begin(), lines.end(), [&](const Line& a, const Line& b) {
+        int orderA = move_order(a.move, board);
+        int orderB = move_order(b.move, board);
+        return orderA != orderB ? orderA > orderB : a.cycles < b.cycles;
+    });
+
+    // Each line is made on the board itself and then taken back again, rather than made on a copy
+    for (const Line& line : lines) {
+        std::optional<MoveRecord> cycled;
+        for (int i = 0; i < line.cycles; i++) {
+            MoveRecord record = board.apply_move<R>(CyclePile {});
+            if (i == 0) {
+                cycled = record;
+            }
+        }
+
+        MoveRecord moved = board.apply_move<R>(line.move);
+        SafeMoveStep safe;
+        if (options.safeMoves) {
+            safe = board.apply_safe_moves<R>();
+        }
+
+        SolveResult result = search<R>(board, depth + 1, nullptr);
+
+        if (options.safeMoves) {
+            board.undo_safe_moves(safe);
+        }
+        board.undo_move(moved);
+        if (cycled) {
+            board.undo_move(*cycled);
+        }
+
+        if (result == SR_Win && firstMove != nullptr) {
+            *firstMove = line.cycles > 0 ? SolitaireMove(CyclePile {}) : line.move;
+        }
+
+        if (result != SR_Loss) {
+            return result;
+        }
+    }
+
+    return SR_Loss;
+}
+
+void solve_benchmark(const SolveBenchmarkOptions& options) {
+    TRACE_SCOPE("solve_benchmark");
+
+    std::unique_ptr<SolutionCache> cache;
+    if (options.cachePath) {
+        cache = std::make_unique<SolutionCache>(*options.cachePath);
+    }
+
+    int workers = worker_count(options.threads);
+    std::vector<std::unique_ptr<Solver>> solvers;
+    for (int i = 0; i < workers; i++) {
+        solvers.push_back(std::make_unique<Solver>(options.solver, cache.get()));
+    }
+
+    std::vector<SolveResult> results(options.games);
+    std::vector<uint64_t> nodes(options.games);
+    std::vector<char> cached(options.games);
+    std::vector<double> solveSeconds(options.games);
+    Timer timer;
+
+    parallel_for(options.games, workers, [&](int worker, int i) {
+        Board board(options.rules);
+        board.deal(options.seed + i);
+
+        Timer solveTimer;
+        SolveStats stats = solvers[worker]->solve(board);
+        solveSeconds[i] = solveTimer.elapsed();
+        results[i] = stats.result;
+        nodes[i] = stats.nodes;
+        cached[i] = stats.cached;
+    });
+
+    int wins = std::count(results.begin(), results.end(), SR_Win);
+    int losses = std::count(results.begin(), results.end(), SR_Loss);
+    int unknown = std::count(results.begin(), results.end(), SR_Unknown);
+
+    // Only the deals searched in this run count towards the speed. The nodes stored with a cached
+    // answer were searched in some other run, and took however long they took then.
+    int searched = 0;
+    uint64_t totalNodes = 0;
+    double searchSeconds = 0;
+    for (int i = 0; i < options.games; i++) {
+        if (!cached[i]) {
+            searched++;
+            totalNodes += nodes[i];
+            searchSeconds += solveSeconds[i];
+        }
+    }
+
+    float games = static_cast<float>(options.games);
+    double seconds = timer.elapsed();
+
+    std::println("solved {} deals ({}, seed {}) in {:.2f}s using {} threads",
+        options.games, describe(options.rules), options.seed, seconds, workers);
+    std::println("  winnable:   {:>8} ({:.2f}%)", wins, 100 * wins / games);
+    std::println("  unwinnable: {:>8} ({:.2f}%)", losses, 100 * losses / games);
+    std::println("  unknown:    {:>8} ({:.2f}%, gave up after {} nodes)", unknown, 100 * unknown / games, options.solver.nodeLimit);
+    std::println("so between {:.2f}% and {:.2f}% of deals can be won", 100 * wins / games, 100 * (wins + unknown) / games);
+    if (searched > 0) {
+        std::println("{} nodes searched over {} deals ({:.0f} per deal, {:.0f} per second per thread)",
+            totalNodes, searched, static_cast<double>(totalNodes) / searched, totalNodes / std::max(searchSeconds, 1e-9));
+    }
+
+    if (cache) {
+        std::println("{} deals answered from the cache at {}, which now knows {} positions",
+            options.games - searched, *options.cachePath, cache->size());
+    }
+}
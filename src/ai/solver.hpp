@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <unordered_set>
+#include "ai.hpp"
+
+class SolutionCache;
+
+// A solver that can see every card, face down ones and the order of the stock included
+// (what's called "thoughtful solitaire"). It can't be used to play fairly, but it tells us
+// whether a deal can be won at all, which gives us a ceiling to compare the ais against.
+
+enum SolveResult {
+    SR_Win,
+    SR_Loss,
+    // We ran out of nodes before finding out
+    SR_Unknown,
+};
+
+struct SolveStats {
+    SolveResult result;
+    uint64_t nodes;
+    // The first move of the winning line, if there is one
+    std::optional<SolitaireMove> firstMove;
+    // Whether this came out of a SolutionCache rather than a search
+    bool cached = false;
+};
+
+// Goes up whenever a change to the search could change what it answers, so the answers saved in
+// a SolutionCache by an older solver don't get used
+const uint32_t SOLVER_VERSION = 2;
+
+struct SolverOptions {
+    // Give up (SR_Unknown) after searching this many positions
+    uint64_t nodeLimit = 1000000;
+    // Give up if a line gets longer than this, so we don't run out of stack
+    int maxDepth = 1500;
+    // Make the safe moves (see Board::apply_safe_moves) after every move instead of searching
+    // them, which finds answers faster. Off by default, since nobody has proven yet that they can
+    // never lose a won game, and if they can the solver would call some wins losses.
+    bool safeMoves = false;
+    // If set, the search gives up (SR_Unknown) as soon as this becomes true, so another thread
+    // can stop it
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+// Depth first search over every line from the given board, skipping positions it has already
+// seen. Keep one around per thread and reuse it, so the memory it uses gets reused too.
+class Solver {
+public:
+    // If there's a cache, positions in it aren't searched again and new answers get added to it
+    Solver(SolverOptions options = {}, SolutionCache* cache = nullptr) : options(options), cache(cache) {}
+
+    SolveStats solve(const Board& board);
+    // For the next solve
+    void set_options(const SolverOptions& newOptions) { options = newOptions; }
+
+private:
+    template <typename R>
+    SolveResult search(Board& board, int depth, std::optional<SolitaireMove>* firstMove);
+
+    SolverOptions options;
+    SolutionCache* cache;
+    uint64_t nodes = 0;
+    std::unordered_set<uint64_t> seen;
+    std::pmr::unsynchronized_pool_resource pool;
+};
+
+struct SolveBenchmarkOptions {
+    RuleSet rules;
+    int games = 1000;
+    int threads = 0;
+    unsigned int seed = 0;
+    SolverOptions solver;
+    // Where to keep answers between runs (see SolutionCache), if anywhere
+    std::optional<std::string> cachePath;
+};
+
+// Solves deals seed, seed + 1, ... (dealt the same way as the benchmark) in parallel, and reports
+// what fraction of them can be won
+void solve_benchmark(const SolveBenchmarkOptions& options);
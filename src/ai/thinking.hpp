@@ -0,0 +1,96 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+#include "src/moves.hpp"
+
+// An ai thinking about a move, as a coroutine that can be paused.
+//
+// Each call to resume() does a slice of work (how much is up to the ai) and then hands control
+// back, with the best move it has found so far in best(). That way the game can think in
+// whatever time a frame has spare, without any threads, and it does exactly the same thing
+// every time, which makes it easy to step through.
+//
+// An ai makes one of these by writing a function that returns Thinking, and using
+// `co_yield move` to pause and `co_return move` when it's done. Nothing runs until the first
+// resume(). Whatever the coroutine was given by reference has to stay alive (and unchanged)
+// until it's finished or the Thinking is destroyed.
+class Thinking {
+public:
+    struct promise_type {
+        std::optional<SolitaireMove> best;
+        std::exception_ptr exception;
+
+        Thinking get_return_object() {
+            return Thinking(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(std::optional<SolitaireMove> move) {
+            best = std::move(move);
+            return {};
+        }
+
+        void return_value(std::optional<SolitaireMove> move) {
+            best = std::move(move);
+        }
+
+        void unhandled_exception() {
+            exception = std::current_exception();
+        }
+    };
+
+    Thinking(Thinking&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Thinking& operator=(Thinking&& other) noexcept {
+        if (this != &other) {
+            if (handle) {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    Thinking(const Thinking&) = delete;
+    Thinking& operator=(const Thinking&) = delete;
+
+    ~Thinking() {
+        if (handle) {
+            handle.destroy();
+        }
+    }
+
+    // Does the next slice of work. Returns false once there's nothing left to do.
+    // Rethrows anything the ai threw.
+    bool resume() {
+        if (done()) {
+            return false;
+        }
+
+        handle.resume();
+
+        if (handle.promise().exception) {
+            std::rethrow_exception(handle.promise().exception);
+        }
+
+        return !done();
+    }
+
+    // Whether the ai has finished and best() is its final answer
+    bool done() const {
+        return handle.done();
+    }
+
+    const std::optional<SolitaireMove>& best() const {
+        return handle.promise().best;
+    }
+
+private:
+    explicit Thinking(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+    std::coroutine_handle<promise_type> handle;
+};
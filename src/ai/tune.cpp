@@ -0,0 +1,112 @@
+#include "tune.hpp"
+#include "benchmark.hpp"
+#include "../board.hpp"
+#include "../parallel.hpp"
+#include "../trace.hpp"
+#include "../utils.hpp"
+#include <algorithm>
+#include <cmath>
+#include <print>
+#include <random>
+#include <vector>
+
+// How many games each set of parameters wins, out of deals firstSeed, firstSeed + 1, ...
+std::vector<int> count_wins(const std::vector<DennisParams>& candidates, const TuneOptions& options, unsigned int firstSeed) {
+    TRACE_SCOPE("count_wins");
+
+    int games = options.games;
+    std::vector<char> won(candidates.size() * games);
+
+    with_rules(options.rules, [&]<typename R>() {
+        parallel_for(won.size(), worker_count(options.threads), [&](int, int job) {
+            unsigned int seed = firstSeed + job % games;
+
+            Board board(options.rules);
+            board.deal(seed);
+            Dennis dennis(candidates[job / games], seed);
+
+            won[job] = play_game<R>(dennis, board).has_value();
+        });
+    });
+
+    std::vector<int> wins(candidates.size());
+    for (size_t job = 0; job < won.size(); job++) {
+        wins[job / games] += won[job];
+    }
+
+    return wins;
+}
+
+// A copy of the parameters with a few of them nudged at random
+DennisParams perturb(const DennisParams& params, std::mt19937& rand) {
+    std::bernoulli_distribution tweak(0.4);
+    std::normal_distribution<float> valueStep(0, 1.5);
+    std::normal_distribution<float> percentStep(0, 15);
+
+    DennisParams tweaked = params;
+
+    for (int k = 0; k < MOVE_KINDS; k++) {
+        if (tweak(rand)) {
+            tweaked.value[k] = std::clamp<int>(std::lround(tweaked.value[k] + valueStep(rand)), 0, 20);
+        }
+        if (tweak(rand)) {
+            tweaked.cyclePercent[k] = std::clamp<int>(std::lround(tweaked.cyclePercent[k] + percentStep(rand)), 0, 100);
+        }
+    }
+
+    return tweaked;
+}
+
+void print_params(const DennisParams& params) {
+    std::println("  {:<20} {:>6} {:>14}", "move kind", "value", "cycle percent");
+    for (int k = 0; k < MOVE_KINDS; k++) {
+        std::println("  {:<20} {:>6} {:>14}", MOVE_KIND_NAMES[k], params.value[k], params.cyclePercent[k]);
+    }
+}
+
+DennisParams tune_dennis(const DennisParams& start, const TuneOptions& options) {
+    TRACE_SCOPE("tune_dennis");
+
+    std::mt19937 rand(options.seed);
+    Timer timer;
+    auto percent = [&](int wins) { return 100.0 * wins / options.games; };
+
+    DennisParams best = start;
+    int bestWins = count_wins({ start }, options, options.seed)[0];
+
+    std::println("tuning dennis on {} deals ({}, seed {}), {} candidates a round",
+        options.games, describe(options.rules), options.seed, options.candidates);
+    std::println("starting parameters won {} ({:.2f}%)", bestWins, percent(bestWins));
+
+    for (int round = 1; round <= options.rounds; round++) {
+        std::vector<DennisParams> candidates;
+        for (int i = 0; i < options.candidates; i++) {
+            candidates.push_back(perturb(best, rand));
+        }
+
+        std::vector<int> wins = count_wins(candidates, options, options.seed);
+        int i = std::max_element(wins.begin(), wins.end()) - wins.begin();
+
+        if (wins[i] > bestWins) {
+            best = candidates[i];
+            bestWins = wins[i];
+            save_dennis_params(options.output, best);
+            std::println("round {}: improved to {} ({:.2f}%), saved to {} [{:.0f}s]",
+                round, bestWins, percent(bestWins), options.output, timer.elapsed());
+        } else {
+            std::println("round {}: best candidate won {}, no improvement [{:.0f}s]", round, wins[i], timer.elapsed());
+        }
+    }
+
+    save_dennis_params(options.output, best);
+
+    // Check it on deals it hasn't seen
+    std::vector<int> check = count_wins({ start, best }, options, options.seed + options.games);
+
+    std::println("\nbest parameters (written to {}):", options.output);
+    print_params(best);
+    std::println("on {} fresh deals the starting parameters won {:.2f}% and these won {:.2f}%",
+        options.games, percent(check[0]), percent(check[1]));
+
+    return best;
+}
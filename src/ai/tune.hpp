@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+#include "dennis.hpp"
+#include "src/rules.hpp"
+
+struct TuneOptions {
+    RuleSet rules;
+    // Every candidate plays these deals (seed, seed + 1, ...)
+    int games = 2000;
+    int rounds = 20;
+    // How many candidates to try each round
+    int candidates = 16;
+    // 0 means one per hardware thread
+    int threads = 0;
+    unsigned int seed = 0;
+    // Where the best parameters get written, every time they improve
+    std::string output = "dennis.params";
+};
+
+// Random search for better DennisParams, starting from `start`.
+//
+// Each round tries some random tweaks of the best parameters so far, all on the same deals and
+// with Dennis's dice seeded by the deal, so the only difference between two candidates is the
+// parameters. At the end the winner is checked against `start` on deals it wasn't tuned on, since
+// the best of a lot of noisy scores always looks a bit better than it really is.
+DennisParams tune_dennis(const DennisParams& start, const TuneOptions& options);
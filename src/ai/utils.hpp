@@ -1,17 +1,97 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
 #include <vector>
 #include "ai.hpp"
+#include "../counters.hpp"
+#include "../trace.hpp"
+
+typedef std::pmr::vector<SolitaireMove> MoveList;
+
+// Scratch memory for a single call to nextMove. Allocating from it is just a pointer bump, and
+// everything is thrown away at once at the start of the next turn. If a turn needs more than the
+// buffer, the rest comes from the heap.
+struct TurnArena {
+    TurnArena() : arena(buffer.data(), buffer.size()) {}
+    TurnArena(const TurnArena&) = delete;
+    TurnArena& operator=(const TurnArena&) = delete;
+
+    // Frees everything allocated last turn and returns the arena to allocate from this turn
+    std::pmr::memory_resource* reset() {
+        arena.release();
+        return &arena;
+    }
 
-std::vector<SolitaireMove> possible_moves_for_card(
+private:
+    std::array<std::byte, 16384> buffer;
+    std::pmr::monotonic_buffer_resource arena;
+};
+
+// Appends the moves that the card can make to `moves`
+void possible_moves_for_card(
     const Card& c,
     bool isSingle /* for you this is always true */,
     CardSource src,
     std::pair<int, int> srcCoord,
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::array<std::vector<Card>, 4>& aces
+    const Board& board,
+    MoveList& moves
 );
 
-std::vector<SolitaireMove> possible_moves(
-    const std::array<std::vector<Card>, 7>& playfield,
-    const std::vector<Card>& pile,
-    const std::array<std::vector<Card>, 4>& aces
-);
+// Every legal move on the board. If cycling the pile is allowed, it is always the first move.
+template <typename R>
+MoveList possible_moves(const Board& board, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+// Same as above, but picks the rules from board.rules
+MoveList possible_moves(const Board& board, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+
+template <typename R>
+MoveList possible_moves(const Board& board, std::pmr::memory_resource* memory) {
+    TRACE_SCOPE("possible_moves");
+
+    const auto& playfield = board.playfield;
+    const auto& pile = board.pile;
+    const auto& aces = board.aces;
+
+    MoveList moves(memory);
+    moves.reserve(32);
+
+    if (board.can_cycle<R>()) {
+        moves.push_back(CyclePile {});
+    }
+
+    if (!pile.empty()) {
+        possible_moves_for_card(pile.back(), true, CS_Pile, { }, board, moves);
+    }
+
+    if constexpr (R::foundationReturn) {
+        for (int i = 0; i < 4; i++) {
+            if (!aces.at(i).empty()) {
+                possible_moves_for_card(aces.at(i).back(), true, CS_Aces, { i, 0 }, board, moves);
+            }
+        }
+    }
+
+    for (int i = 0; i < 7; i++) {
+        for (int j = 0; j < (int)playfield.at(i).size(); j++) {
+            const Card& c = playfield.at(i).at(j);
+
+            if (c.upturned) {
+                possible_moves_for_card(
+                    c,
+                    j == (int)playfield.at(i).size() - 1,
+                    CS_Playfield,
+                    { i, j },
+                    board,
+                    moves
+                );
+            }
+        }
+    }
+
+    WorkCounters& counters = thread_counters();
+    counters.possibleMovesCalls++;
+    counters.movesGenerated += moves.size();
+
+    return moves;
+}
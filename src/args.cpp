@@ -0,0 +1,102 @@
+#include "args.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <format>
+#include <stdexcept>
+
+Args::Args(int argc, char** argv, const std::vector<std::string_view>& flags) {
+    for (int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+
+        if (!arg.starts_with("--")) {
+            positional.push_back(std::string(arg));
+            continue;
+        }
+
+        std::string name(arg.substr(2));
+
+        if (std::find(flags.begin(), flags.end(), name) != flags.end()) {
+            options[name] = "";
+        } else if (i + 1 < argc) {
+            options[name] = argv[++i];
+        } else {
+            throw std::runtime_error(std::format("Option \"{}\" needs a value", arg));
+        }
+    }
+}
+
+bool Args::has(std::string_view name) const {
+    return options.find(name) != options.end();
+}
+
+std::optional<std::string> Args::get(std::string_view name) const {
+    if (auto it = options.find(name); it != options.end()) {
+        return it->second;
+    } else {
+        return std::nullopt;
+    }
+}
+
+std::vector<std::string> Args::get_list(std::string_view name) const {
+    std::vector<std::string> items;
+    std::optional<std::string> value = get(name);
+    if (!value) {
+        return items;
+    }
+
+    size_t start = 0;
+    while (true) {
+        size_t comma = value->find(',', start);
+        items.push_back(value->substr(start, comma - start));
+        if (comma == std::string::npos) {
+            break;
+        }
+        start = comma + 1;
+    }
+
+    return items;
+}
+
+int Args::get_int(std::string_view name, int defaultValue) const {
+    std::optional<std::string> value = get(name);
+    return value ? parse_int(name, *value) : defaultValue;
+}
+
+double Args::get_double(std::string_view name, double defaultValue) const {
+    std::optional<std::string> value = get(name);
+    return value ? parse_double(name, *value) : defaultValue;
+}
+
+void Args::expect(std::initializer_list<std::vector<std::string_view>> known) const {
+    for (const auto& [name, value] : options) {
+        bool found = std::any_of(known.begin(), known.end(), [&](const std::vector<std::string_view>& names) {
+            return std::find(names.begin(), names.end(), name) != names.end();
+        });
+
+        if (!found) {
+            throw std::runtime_error(std::format("Unknown option \"--{}\"", name));
+        }
+    }
+}
+
+template <typename T>
+T parse_number(std::string_view option, std::string_view value) {
+    T result;
+    const char* end = value.data() + value.size();
+    auto [ptr, error] = std::from_chars(value.data(), end, result);
+
+    if (value.empty() || error != std::errc() || ptr != end) {
+        throw std::runtime_error(std::format("Option \"--{}\" should be a number, not \"{}\"", option, value));
+    }
+
+    return result;
+}
+
+int parse_int(std::string_view option, std::string_view value) {
+    return parse_number<int>(option, value);
+}
+
+double parse_double(std::string_view option, std::string_view value) {
+    return parse_number<double>(option, value);
+}
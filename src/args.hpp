@@ -0,0 +1,39 @@
+#pragma once
+
+#include <initializer_list>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A very small command line parser.
+//
+// Anything starting with "--" is an option. It takes the next argument as its value, unless it
+// is listed as a flag (an option without a value). Everything else is positional, in order.
+struct Args {
+    Args(int argc, char** argv, const std::vector<std::string_view>& flags = {});
+
+    // The positional arguments, not including the program name
+    std::vector<std::string> positional;
+
+    bool has(std::string_view name) const;
+    std::optional<std::string> get(std::string_view name) const;
+    // For options that take a comma separated list like "--draw 1,3". Empty if it isn't there.
+    std::vector<std::string> get_list(std::string_view name) const;
+    // These throw if the option is there but isn't a valid number
+    int get_int(std::string_view name, int defaultValue) const;
+    double get_double(std::string_view name, double defaultValue) const;
+
+    // Throws if any option was given that isn't in one of these lists, so typos like "--draww"
+    // don't get silently ignored
+    void expect(std::initializer_list<std::vector<std::string_view>> known) const;
+
+private:
+    std::map<std::string, std::string, std::less<>> options;
+};
+
+// The whole of value has to be a number, so "1,3" or "12abc" are errors rather than 1 and 12.
+// option is only used for the error message.
+int parse_int(std::string_view option, std::string_view value);
+double parse_double(std::string_view option, std::string_view value);
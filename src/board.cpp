@@ -0,0 +1,407 @@
+#include "board.hpp"
+
+#include <algorithm>
+#include <format>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+#include "counters.hpp"
+
+template <size_t N>
+std::array<CardStack, N> make_stacks(std::pmr::memory_resource* memory) {
+    return [memory]<size_t... I>(std::index_sequence<I...>) {
+        return std::array<CardStack, N> { (static_cast<void>(I), CardStack(memory))... };
+    }(std::make_index_sequence<N>());
+}
+
+Board::Board(RuleSet rules, std::pmr::memory_resource* memory) :
+    playfield(make_stacks<7>(memory)),
+    aces(make_stacks<4>(memory)),
+    stock(memory),
+    pile(memory),
+    rules(rules)
+{}
+
+Board::Board(const Board& other, std::pmr::memory_resource* memory) : Board(other.rules, memory) {
+    for (int i = 0; i < 7; i++) {
+        playfield[i].assign(other.playfield[i].begin(), other.playfield[i].end());
+    }
+
+    for (int i = 0; i < 4; i++) {
+        aces[i].assign(other.aces[i].begin(), other.aces[i].end());
+    }
+
+    stock.assign(other.stock.begin(), other.stock.end());
+    pile.assign(other.pile.begin(), other.pile.end());
+    redeals = other.redeals;
+}
+
+void Board::deal(std::mt19937& rand) {
+    // Reserving the most space each pile could ever need means nothing has to grow later, which is
+    // what we want when allocating from an arena
+    for (int i = 0; i < 7; i++) {
+        playfield.at(i).clear();
+        // 6 face down cards and a king to ace run
+        playfield.at(i).reserve(19);
+    }
+
+    pile.clear();
+    stock.clear();
+    pile.reserve(24);
+    redeals = 0;
+
+    for (int i = 0; i < 4; i++) {
+        aces.at(i).clear();
+        aces.at(i).reserve(13);
+    }
+
+    // populate the deck and shuffle it
+    stock.reserve(52);
+    for (int s = 0; s < 4; s++) {
+        for (int v = 0; v < 13; v++) {
+            Suit suit = static_cast<Suit>(s);
+            Value value = static_cast<Value>(v);
+
+            stock.push_back(Card(value, suit));
+        }
+    }
+
+    std::shuffle(stock.begin(), stock.end(), rand);
+
+    // Deal cards to the playfield
+    for (int i = 7; i >= 1; i--) {
+        for (int j = 7 - i; j < 7; j++) {
+            Card c = stock.back();
+            stock.pop_back();
+            c.upturned = j == 7 - i;
+            playfield.at(j).push_back(c);
+        }
+    }
+}
+
+void Board::deal(unsigned int seed) {
+    std::mt19937 rand(seed);
+    deal(rand);
+}
+
+bool Board::is_solved() const {
+    bool all_upturned = true;
+
+    for (int i = 0; i < 7; i++) {
+        for (auto c = playfield.at(i).begin(); c != playfield.at(i).end(); c++) {
+            all_upturned &= c->upturned;
+        }
+    }
+
+    return pile.size() == 0 && stock.size() == 0 && all_upturned;
+}
+
+// The finaliser from splitmix64, which is a cheap way of getting well mixed bits
+uint64_t mix(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111eb;
+    h ^= h >> 31;
+    return h;
+}
+
+void hash_stack(uint64_t& h, const CardStack& stack) {
+    for (const Card& c : stack) {
+        h = mix(h + c.index() * 2 + c.upturned + 1);
+    }
+
+    // So that moving a card from the end of one stack to the start of the next changes the hash
+    h = mix(h + 0xFF);
+}
+
+uint64_t Board::state_hash() const {
+    uint64_t h = 0;
+
+    for (const CardStack& stack : playfield) {
+        hash_stack(h, stack);
+    }
+
+    // Only the top card of each aces pile matters
+    for (const CardStack& acesPile : aces) {
+        h = mix(h + (acesPile.empty() ? 0 : acesPile.back().index() + 1));
+    }
+
+    hash_stack(h, stock);
+    hash_stack(h, pile);
+
+    // With unlimited passes, it doesn't matter how many we've used
+    if (rules.passes != 0) {
+        h = mix(h + redeals);
+    }
+
+    return h;
+}
+
+uint64_t Board::canonical_hash() const {
+    // Hash each stack on its own, and combine them in sorted order
+    std::array<uint64_t, 7> stackHashes;
+    for (int i = 0; i < 7; i++) {
+        stackHashes[i] = 0;
+        hash_stack(stackHashes[i], playfield[i]);
+    }
+    std::sort(stackHashes.begin(), stackHashes.end());
+
+    uint64_t h = 0;
+    for (uint64_t stackHash : stackHashes) {
+        h = mix(h + stackHash);
+    }
+
+    // How far along each suit is, in suit order rather than pile order
+    std::array<int, 4> suitCounts {};
+    for (const CardStack& acesPile : aces) {
+        if (!acesPile.empty()) {
+            suitCounts[acesPile.back().suit] = acesPile.back().value + 1;
+        }
+    }
+    for (int count : suitCounts) {
+        h = mix(h + count);
+    }
+
+    hash_stack(h, stock);
+    hash_stack(h, pile);
+
+    if (rules.passes != 0) {
+        h = mix(h + redeals);
+    }
+
+    return h;
+}
+
+const Card& Board::get_card(CardSource src, std::pair<int, int> coord) const {
+    switch (src) {
+        case CS_Pile:
+            if (pile.empty()) {
+                throw std::runtime_error("Pile is empty but get_card was called on it");
+            }
+
+            return pile.back();
+
+        case CS_Playfield:
+            return playfield.at(coord.first).at(coord.second);
+
+        case CS_Aces:
+            if (aces.at(coord.first).empty()) {
+                throw std::runtime_error(std::format("Aces pile {} empty but get_card was called on it", coord.first));
+            }
+
+            return aces.at(coord.first).back();
+        default:
+            throw std::runtime_error("Invalid card source");
+    }
+}
+
+CardStack Board::pop_cards(CardSource src, std::pair<int, int> coord) {
+    CardStack res(stock.get_allocator());
+    switch (src) {
+        case CS_Pile:
+            if (pile.empty()) {
+                throw std::runtime_error("Pile is empty but get_card was called on it");
+            }
+
+            res.push_back(pile.back());
+            pile.pop_back();
+            break;
+
+        case CS_Playfield:
+            for (int i = coord.second; i < (int)playfield.at(coord.first).size(); i++) {
+                res.push_back(playfield.at(coord.first).at(i));
+            }
+
+            playfield.at(coord.first).erase(playfield.at(coord.first).begin() + coord.second, playfield.at(coord.first).end());
+
+            if (!playfield.at(coord.first).empty()) {
+                playfield.at(coord.first).back().upturned = true;
+            }
+            break;
+
+        case CS_Aces:
+            if (aces.at(coord.first).empty()) {
+                throw std::runtime_error(std::format("Aces pile {} empty but get_card was called on it", coord.first));
+            }
+
+            res.push_back(aces.at(coord.first).back());
+            aces.at(coord.first).pop_back();
+    }
+
+    return res;
+}
+
+bool Board::can_cycle() const {
+    return with_rules(rules, [&]<typename R>() { return can_cycle<R>(); });
+}
+
+void Board::deal_or_reset_stock() {
+    with_rules(rules, [&]<typename R>() { deal_or_reset_stock<R>(); });
+}
+
+MoveRecord Board::apply_move(const SolitaireMove& move) {
+    return with_rules(rules, [&]<typename R>() { return apply_move<R>(move); });
+}
+
+SafeMoveStep Board::apply_safe_moves() {
+    return with_rules(rules, [&]<typename R>() { return apply_safe_moves<R>(); });
+}
+
+int Board::safe_aces_pile(const Card& c, bool foundationReturn) const {
+    // How many of each suit are on the aces, and where
+    std::array<int, 4> count {};
+    std::array<int, 4> pileOf = { -1, -1, -1, -1 };
+    int firstEmpty = -1;
+
+    for (int i = 0; i < 4; i++) {
+        if (aces[i].empty()) {
+            firstEmpty = firstEmpty < 0 ? i : firstEmpty;
+        } else {
+            count[aces[i].back().suit] = aces[i].back().value + 1;
+            pileOf[aces[i].back().suit] = i;
+        }
+    }
+
+    if (count[c.suit] != c.value) {
+        return -1;
+    }
+
+    bool safe = c.value <= Two;
+    if (!safe) {
+        bool red = c.is_red();
+        int lowest = 13;
+        for (int s = 0; s < 4; s++) {
+            if (card_tables::suit_is_red(static_cast<Suit>(s)) != red) {
+                lowest = std::min(lowest, count[s]);
+            }
+        }
+        safe = lowest >= c.value;
+
+        // When cards can come back down, one of the other colour one lower might be brought down
+        // onto this card to free one of this colour two lower, so that has to be up too
+        if (safe && foundationReturn) {
+            for (int s = 0; s < 4; s++) {
+                if (s != c.suit && card_tables::suit_is_red(static_cast<Suit>(s)) == red) {
+                    safe = count[s] >= c.value - 1;
+                }
+            }
+        }
+    }
+
+    if (!safe) {
+        return -1;
+    }
+
+    return c.value == Ace ? firstEmpty : pileOf[c.suit];
+}
+
+void Board::apply_safe_move(const MoveToAces& m, SafeMoveStep& step) {
+    MoveRecord record;
+    move_to_aces(m, record);
+    step.moves[step.count++] = SafeMove { m, record.uncovered };
+    thread_counters().safeMoves++;
+}
+
+void Board::undo_safe_moves(const SafeMoveStep& step) {
+    for (int i = step.count - 1; i >= 0; i--) {
+        const SafeMove& safe = step.moves[i];
+        CardStack& acesPile = aces.at(safe.move.toAcesId);
+        Card c = acesPile.back();
+        acesPile.pop_back();
+
+        if (safe.move.source == CS_Pile) {
+            pile.push_back(c);
+        } else {
+            CardStack& stack = playfield.at(safe.move.fromCoord.first);
+            if (safe.uncovered) {
+                stack.back().upturned = false;
+            }
+            stack.push_back(c);
+        }
+    }
+}
+
+// Whether taking the cards at coord off the playfield will turn over the card under them
+bool uncovers(const Board& board, CardSource source, std::pair<int, int> coord) {
+    return source == CS_Playfield && coord.second > 0
+        && !board.playfield.at(coord.first).at(coord.second - 1).upturned;
+}
+
+void Board::move_to_stack(const MoveToStack& m, MoveRecord& record) {
+    const Card& selectedCard = get_card(m.source, m.fromCoord);
+
+    if (!can_go_on_stack(selectedCard, playfield.at(m.toStackId))) {
+        throw std::runtime_error("Tried to place a card on a stack that it cant go on");
+    }
+
+    record.uncovered = uncovers(*this, m.source, m.fromCoord);
+    CardStack cards = pop_cards(m.source, m.fromCoord);
+    record.count = cards.size();
+    for (auto c = cards.begin(); c != cards.end(); c++) {
+        playfield.at(m.toStackId).push_back(*c);
+    }
+}
+
+void Board::move_to_aces(const MoveToAces& m, MoveRecord& record) {
+    const Card& selectedCard = get_card(m.source, m.fromCoord);
+
+    if (!can_go_on_aces(selectedCard, aces.at(m.toAcesId))) {
+        throw std::runtime_error(std::format(
+            "Tried to put a card in an ace space where it cant go. card value: {}, suit: {}",
+            static_cast<int>(selectedCard.value),
+            static_cast<int>(selectedCard.suit)
+        ));
+    }
+
+    record.uncovered = uncovers(*this, m.source, m.fromCoord);
+    CardStack cards = pop_cards(m.source, m.fromCoord);
+    if (cards.size() != 1) {
+        throw std::runtime_error("Tried to play an invalid move!");
+    }
+    record.count = 1;
+
+    aces.at(m.toAcesId).push_back(cards[0]);
+}
+
+void Board::undo_move(const MoveRecord& record) {
+    if (std::holds_alternative<CyclePile>(record.move)) {
+        redeals = record.redeals;
+
+        while ((int)pile.size() > record.pileSize) {
+            stock.push_back(pile.back());
+            pile.pop_back();
+        }
+
+        while ((int)pile.size() < record.pileSize) {
+            pile.push_back(stock.back());
+            stock.pop_back();
+        }
+
+        return;
+    }
+
+    CardSource source;
+    std::pair<int, int> from;
+    CardStack* to;
+
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&record.move)) {
+        source = m->source;
+        from = m->fromCoord;
+        to = &playfield.at(m->toStackId);
+    } else {
+        const MoveToAces& a = std::get<MoveToAces>(record.move);
+        source = a.source;
+        from = a.fromCoord;
+        to = &aces.at(a.toAcesId);
+    }
+
+    CardStack& back = source == CS_Pile ? pile : source == CS_Aces ? aces.at(from.first) : playfield.at(from.first);
+    if (record.uncovered) {
+        back.back().upturned = false;
+    }
+
+    back.insert(back.end(), to->end() - record.count, to->end());
+    to->erase(to->end() - record.count, to->end());
+}
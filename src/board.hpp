@@ -0,0 +1,229 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <memory_resource>
+#include <random>
+#include <stdexcept>
+#include <variant>
+#include <vector>
+#include "cards.hpp"
+#include "counters.hpp"
+#include "moves.hpp"
+#include "rules.hpp"
+
+// All the containers on the board allocate from the board's memory resource. The benchmark gives
+// each board an arena that gets thrown away after every game, so dealing and moving cards doesn't
+// touch the global heap at all.
+typedef std::pmr::vector<Card> CardStack;
+
+// A card apply_safe_moves put on the aces, and what's needed to take it back off
+struct SafeMove {
+    MoveToAces move;
+    // Whether taking the card off the playfield turned over the card under it
+    bool uncovered;
+};
+
+// Everything one call to apply_safe_moves did, in the order it did it. There can't be more safe
+// moves than cards, so this never allocates.
+struct SafeMoveStep {
+    std::array<SafeMove, 52> moves;
+    int count = 0;
+};
+
+// What one apply_move did, and everything undo_move needs to take it back. A few bytes whatever
+// the move was, so keeping one per move (see history.hpp) is cheap however long the game goes.
+struct MoveRecord {
+    SolitaireMove move;
+    // How many cards moved. Only ever more than one for runs moved between playfield stacks.
+    int count = 0;
+    // Whether taking the cards off a playfield stack turned over the card under them
+    bool uncovered = false;
+    // For CyclePile, the size of the pile and the number of redeals before. Dealing and turning
+    // the pile over never change the order of the stock followed by the pile top down, only
+    // where it's split, so that's all it takes to put them back.
+    int pileSize = 0;
+    int redeals = 0;
+};
+
+// The state of a game of solitaire and the rules for changing it.
+// This doesn't know anything about rendering, so the benchmark can run as many as it likes.
+//
+// The functions that depend on the rules come in two flavours. The templated ones take the Rules
+// type (see rules.hpp) and are what hot loops should use. The plain ones look at `rules` and
+// pick the right template every time they're called.
+struct Board {
+    Board(RuleSet rules, std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+    // Copies the other board, but allocates from the given memory
+    Board(const Board& other, std::pmr::memory_resource* memory);
+
+    std::array<CardStack, 7> playfield;
+    std::array<CardStack, 4> aces;
+    CardStack stock;
+    CardStack pile;
+    RuleSet rules;
+    // How many times the pile has been turned back over into the stock
+    int redeals = 0;
+
+    // Clears the board and deals a new game, shuffled with the given rng
+    void deal(std::mt19937& rand);
+    // Same as above, but the deal is entirely determined by the seed
+    void deal(unsigned int seed);
+
+    bool is_solved() const;
+
+    // A hash of everything that affects what can happen from here on. Two boards with the same
+    // hash can be treated as the same position.
+    uint64_t state_hash() const;
+    // Like state_hash, but boards that only differ by which stack or aces pile is which get the
+    // same hash. The rules don't care about the order of either, so whether one of these boards
+    // can be won says the same about the rest. Moves aren't interchangeable between them though,
+    // since those refer to stacks by number.
+    uint64_t canonical_hash() const;
+
+    const Card& get_card(CardSource src, std::pair<int, int> coord) const;
+    CardStack pop_cards(CardSource src, std::pair<int, int> coord);
+
+    // Whether dealing from the stock (or turning the pile back over) is allowed right now
+    template <typename R> bool can_cycle() const;
+    bool can_cycle() const;
+
+    // Throws if the stock is empty and we're out of passes
+    template <typename R> void deal_or_reset_stock();
+    void deal_or_reset_stock();
+
+    // Checks that the move is legal and makes it. Throws if the move isn't legal. Returns what it
+    // did, in case it needs undoing.
+    template <typename R> MoveRecord apply_move(const SolitaireMove& move);
+    MoveRecord apply_move(const SolitaireMove& move);
+    // Takes back the move, which has to be the last thing that changed the board. Undoing a
+    // CyclePile also undoes any more CyclePiles made straight after it.
+    void undo_move(const MoveRecord& record);
+
+    // Puts every card on the aces that can never be needed anywhere else, until there are none
+    // left. A card is safe to put up if it's an ace or a two, or if both cards of the other colour
+    // one lower are already up, since then nothing could ever go on it. When cards can be moved
+    // back down from the aces, the other card of its colour two lower has to be up as well.
+    //
+    // Cards are taken from the playfield stacks left to right, then the pile. With draw 3 the pile
+    // is left alone, because taking a card out changes which cards turn up on the next pass.
+    template <typename R> SafeMoveStep apply_safe_moves();
+    SafeMoveStep apply_safe_moves();
+    // Takes back everything a call to apply_safe_moves did. Nothing else can have changed since.
+    void undo_safe_moves(const SafeMoveStep& step);
+
+private:
+    // The parts of apply_move that don't depend on the rules
+    void move_to_stack(const MoveToStack& m, MoveRecord& record);
+    void move_to_aces(const MoveToAces& m, MoveRecord& record);
+
+    // If the card is safe to put on the aces (see apply_safe_moves), which aces pile it goes on.
+    // Otherwise -1.
+    int safe_aces_pile(const Card& c, bool foundationReturn) const;
+    // Makes the move and adds it to the step
+    void apply_safe_move(const MoveToAces& m, SafeMoveStep& step);
+};
+
+// Whether the card can be put on top of this stack on the playfield
+inline bool can_go_on_stack(const Card& c, const CardStack& stack) {
+    return stack.empty() ? c.value == King : c.can_be_placed_on(stack.back());
+}
+
+// Whether the card can be put on top of this pile on the aces
+inline bool can_go_on_aces(const Card& c, const CardStack& acesPile) {
+    return acesPile.empty() ? c.value == Ace : c.follows_on_aces(acesPile.back());
+}
+
+template <typename R>
+bool Board::can_cycle() const {
+    if constexpr (R::passes == 0) {
+        return true;
+    } else {
+        return !stock.empty() || redeals < R::passes - 1;
+    }
+}
+
+template <typename R>
+void Board::deal_or_reset_stock() {
+    thread_counters().pileCycles++;
+
+    if (stock.empty()) {
+        if (!can_cycle<R>()) {
+            throw std::runtime_error("Tried to go through the stock again but there are no passes left");
+        }
+
+        // Move cards from the pile to the stock
+        redeals++;
+        while (!pile.empty()) {
+            stock.push_back(pile.back());
+            pile.pop_back();
+        }
+    } else {
+        // Deal up to R::draw cards
+        int count = std::min<int>(R::draw, stock.size());
+
+        for (int i = 0; i < count; i++) {
+            pile.push_back(stock.back());
+            stock.pop_back();
+        }
+    }
+}
+
+template <typename R>
+SafeMoveStep Board::apply_safe_moves() {
+    SafeMoveStep step;
+    bool moved = true;
+
+    while (moved) {
+        moved = false;
+
+        for (int i = 0; i < 7; i++) {
+            const CardStack& stack = playfield[i];
+            if (stack.empty()) {
+                continue;
+            }
+
+            if (int target = safe_aces_pile(stack.back(), R::foundationReturn); target >= 0) {
+                apply_safe_move(MoveToAces { CS_Playfield, { i, (int)stack.size() - 1 }, target }, step);
+                moved = true;
+            }
+        }
+
+        if constexpr (R::draw == 1) {
+            if (!pile.empty()) {
+                if (int target = safe_aces_pile(pile.back(), R::foundationReturn); target >= 0) {
+                    apply_safe_move(MoveToAces { CS_Pile, { }, target }, step);
+                    moved = true;
+                }
+            }
+        }
+    }
+
+    return step;
+}
+
+template <typename R>
+MoveRecord Board::apply_move(const SolitaireMove& move) {
+    thread_counters().movesApplied++;
+
+    MoveRecord record;
+    record.move = move;
+
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        if constexpr (!R::foundationReturn) {
+            if (m->source == CS_Aces) {
+                throw std::runtime_error("Tried to move a card down from the aces, which the rules don't allow");
+            }
+        }
+
+        move_to_stack(*m, record);
+    } else if (const MoveToAces* m = std::get_if<MoveToAces>(&move)) {
+        move_to_aces(*m, record);
+    } else {
+        record.pileSize = pile.size();
+        record.redeals = redeals;
+        deal_or_reset_stock<R>();
+    }
+
+    return record;
+}
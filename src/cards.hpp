@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
+
 enum Value {
     Ace,
     Two,
@@ -23,14 +26,84 @@ enum Suit {
     Spades,
 };
 
+// Every card as a number from 0 to 51, for indexing into the tables below
+constexpr int card_index(Value value, Suit suit) {
+    return static_cast<int>(suit) * 13 + static_cast<int>(value);
+}
+
+// The rules about which card can go where, worked out at compile time.
+// Each check is then just a load from one of these.
+namespace card_tables {
+
+constexpr bool suit_is_red(Suit s) {
+    return s == Hearts || s == Diamonds;
+}
+
+// Bit i is set if card i is red
+constexpr uint64_t RED_MASK = [] {
+    uint64_t mask = 0;
+    for (int i = 0; i < 52; i++) {
+        if (suit_is_red(static_cast<Suit>(i / 13))) {
+            mask |= uint64_t(1) << i;
+        }
+    }
+    return mask;
+}();
+
+// Bit j of CAN_STACK_ON[i] is set if card i can be placed on card j on the playfield
+// (different colours, and card i is one less in value)
+constexpr std::array<uint64_t, 52> CAN_STACK_ON = [] {
+    std::array<uint64_t, 52> table {};
+    for (int i = 0; i < 52; i++) {
+        for (int j = 0; j < 52; j++) {
+            bool differentColours = ((RED_MASK >> i) & 1) != ((RED_MASK >> j) & 1);
+            if (differentColours && i % 13 == j % 13 - 1) {
+                table[i] |= uint64_t(1) << j;
+            }
+        }
+    }
+    return table;
+}();
+
+// FOUNDATION_SUCCESSOR[i] is the card that goes on top of card i on the aces, or -1 for kings
+constexpr std::array<int8_t, 52> FOUNDATION_SUCCESSOR = [] {
+    std::array<int8_t, 52> table {};
+    for (int i = 0; i < 52; i++) {
+        table[i] = i % 13 == King ? -1 : i + 1;
+    }
+    return table;
+}();
+
+}
+
 struct Card {
     Value value;
     Suit suit;
     bool upturned;
 
     Card() {}
-    Card(Value value, Suit suit) : value(value), suit(suit), upturned(true) {}
-    Card(Value value, Suit suit, bool upturned) : value(value), suit(suit), upturned(upturned) {}
+    constexpr Card(Value value, Suit suit) : value(value), suit(suit), upturned(true) {}
+    constexpr Card(Value value, Suit suit, bool upturned) : value(value), suit(suit), upturned(upturned) {}
+
+    constexpr int index() const { return card_index(value, suit); }
 
-    bool can_be_placed_on(const Card& other) const;
+    constexpr bool is_red() const {
+        return (card_tables::RED_MASK >> index()) & 1;
+    }
+
+    // Whether this card can go on top of the other one on the playfield
+    constexpr bool can_be_placed_on(const Card& other) const {
+        return (card_tables::CAN_STACK_ON[index()] >> other.index()) & 1;
+    }
+
+    // Whether this card can go on top of the other one on the aces
+    constexpr bool follows_on_aces(const Card& other) const {
+        return card_tables::FOUNDATION_SUCCESSOR[other.index()] == index();
+    }
 };
+
+static_assert(Card(Six, Hearts).can_be_placed_on(Card(Seven, Spades)));
+static_assert(!Card(Six, Hearts).can_be_placed_on(Card(Seven, Diamonds)));
+static_assert(!Card(King, Clubs).can_be_placed_on(Card(Ace, Hearts)));
+static_assert(Card(Two, Clubs).follows_on_aces(Card(Ace, Clubs)));
+static_assert(!Card(Ace, Spades).follows_on_aces(Card(King, Clubs)));
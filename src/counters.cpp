@@ -0,0 +1,19 @@
+#include "counters.hpp"
+
+WorkCounters& WorkCounters::operator+=(const WorkCounters& other) {
+    possibleMovesCalls += other.possibleMovesCalls;
+    movesGenerated += other.movesGenerated;
+    movesApplied += other.movesApplied;
+    pileCycles += other.pileCycles;
+    safeMoves += other.safeMoves;
+    nodesSearched += other.nodesSearched;
+    nodesReused += other.nodesReused;
+    nextMoveCalls += other.nextMoveCalls;
+    nextMoveSeconds += other.nextMoveSeconds;
+    return *this;
+}
+
+WorkCounters& thread_counters() {
+    thread_local WorkCounters counters;
+    return counters;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+// Counts of the core work done by the engine and the ais, so the benchmark can tell whether a
+// change made an ai smarter or just faster.
+//
+// Each thread has its own set, so counting is just an increment. The benchmark resets them when a
+// worker starts and adds them all up at the end.
+struct WorkCounters {
+    uint64_t possibleMovesCalls = 0;
+    uint64_t movesGenerated = 0;
+    uint64_t movesApplied = 0;
+    uint64_t pileCycles = 0;
+    // Cards Board::apply_safe_moves put on the aces
+    uint64_t safeMoves = 0;
+    // Only search ais count these
+    uint64_t nodesSearched = 0;
+    // Positions a search ai already knew about from an earlier turn
+    uint64_t nodesReused = 0;
+    uint64_t nextMoveCalls = 0;
+    double nextMoveSeconds = 0;
+
+    WorkCounters& operator+=(const WorkCounters& other);
+};
+
+WorkCounters& thread_counters();
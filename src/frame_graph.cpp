@@ -0,0 +1,95 @@
+#ifdef BS_TRACING
+
+#include "frame_graph.hpp"
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+#include <algorithm>
+#include <cstdlib>
+#include <format>
+
+const char* DEFAULT_FONT = "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf";
+const int FONT_SIZE = 14;
+
+const int GRAPH_X = 10;
+const int GRAPH_Y = 10;
+const int GRAPH_HEIGHT = 100;
+const int BAR_WIDTH = 2;
+// How many pixels tall a bar is per millisecond
+const float PIXELS_PER_MS = 3;
+const float TARGET_FRAME_MS = 1000.f / 60.f;
+
+FrameGraph::FrameGraph() {
+    if (TTF_Init() < 0) {
+        return;
+    }
+
+    const char* path = std::getenv("BS_FONT");
+    font = TTF_OpenFont(path ? path : DEFAULT_FONT, FONT_SIZE);
+}
+
+FrameGraph::~FrameGraph() {
+    if (font != nullptr) {
+        TTF_CloseFont(font);
+    }
+
+    TTF_Quit();
+}
+
+void FrameGraph::push(float frameTime) {
+    times[next % times.size()] = frameTime;
+    next++;
+}
+
+void FrameGraph::render(Renderer& renderer) {
+    if (!visible) {
+        return;
+    }
+
+    int width = times.size() * BAR_WIDTH;
+
+    renderer.set_draw_colour(0x20, 0x20, 0x20, 0xFF);
+    renderer.fill_rect(SDL_Rect { GRAPH_X, GRAPH_Y, width, GRAPH_HEIGHT });
+
+    // Oldest frame on the left
+    for (size_t i = 0; i < times.size(); i++) {
+        float ms = times[(next + i) % times.size()] * 1000.f;
+        int height = std::min(static_cast<int>(ms * PIXELS_PER_MS), GRAPH_HEIGHT);
+
+        if (ms > TARGET_FRAME_MS) {
+            renderer.set_draw_colour(0xE0, 0x40, 0x40, 0xFF);
+        } else {
+            renderer.set_draw_colour(0x60, 0xE0, 0x60, 0xFF);
+        }
+
+        renderer.fill_rect(SDL_Rect { GRAPH_X + static_cast<int>(i) * BAR_WIDTH, GRAPH_Y + GRAPH_HEIGHT - height, BAR_WIDTH, height });
+    }
+
+    // A line for 60fps
+    renderer.set_draw_colour(0xFF, 0xFF, 0xFF, 0xFF);
+    int targetY = GRAPH_Y + GRAPH_HEIGHT - static_cast<int>(TARGET_FRAME_MS * PIXELS_PER_MS);
+    renderer.fill_rect(SDL_Rect { GRAPH_X, targetY, width, 1 });
+
+    if (font == nullptr) {
+        return;
+    }
+
+    // Rendering text every frame would show up in the graph itself, so only do it every so often
+    if (next % 10 == 0 || label.inner() == nullptr) {
+        float last = times[(next + times.size() - 1) % times.size()] * 1000.f;
+        float worst = *std::max_element(times.begin(), times.end()) * 1000.f;
+        std::string text = std::format("frame {:.2f}ms (max {:.2f}ms)", last, worst);
+
+        SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text.c_str(), SDL_Color { 0xFF, 0xFF, 0xFF, 0xFF });
+        if (surface == nullptr) {
+            return;
+        }
+
+        label = Texture(renderer, surface);
+        SDL_FreeSurface(surface);
+    }
+
+    renderer.draw_texture(label, GRAPH_X + 4, GRAPH_Y + 4);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#ifdef BS_TRACING
+
+#include <SDL_ttf.h>
+#include <array>
+#include "sdl_wrapper.hpp"
+
+// An on-screen graph of the most recent frame times, toggled with F3. Only exists in tracing
+// builds (see trace.hpp).
+//
+// The label needs a font, which is loaded from the path in BS_FONT (or a common system path).
+// If there isn't one we just draw the bars.
+struct FrameGraph {
+    FrameGraph();
+    FrameGraph(const FrameGraph&) = delete;
+    FrameGraph& operator=(const FrameGraph&) = delete;
+    ~FrameGraph();
+
+    void push(float frameTime);
+    void render(Renderer& renderer);
+
+    bool visible = false;
+
+private:
+    std::array<float, 150> times {};
+    size_t next = 0;
+
+    TTF_Font* font = nullptr;
+    Texture label;
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include <SDL.h>
-#include <SDL_image.h>
 #include <algorithm>
 #include <random>
 #include <print>
@@ -8,53 +7,46 @@
 
 #include "game.hpp"
 #include "cards.hpp"
+#include "layout.hpp"
 #include "ai/ai.hpp"
+#include "trace.hpp"
 #include "utils.hpp"
-
-const int WINDOW_WIDTH = 900;
-const int WINDOW_HEIGHT = 800;
-
-const int CARD_TILE_WIDTH = 64;
-const int CARD_TILE_HEIGHT = 64;
-const int CARD_TILE_OFFSET_X = 11;
-const int CARD_TILE_OFFSET_Y = 2;
-const int CARD_SPRITE_WIDTH = 42;
-const int CARD_SPRITE_HEIGHT = 60;
-const int CARD_UPSCALE = 2;
-
-const int PLAYFIELD_START_X = 100;
-const int PLAYFIELD_START_Y = 200;
-const int PLAYFIELD_CARD_DX = 110;
-const int PLAYFIELD_UP_CARD_DY = 30;
-const int PLAYFIELD_DOWN_CARD_DY = 15;
-
-const int STOCK_X = 100;
-const int PILE_X = 210;
-const int PILE_DX = 30;
-const int STOCK_PILE_Y = 50;
-
-const int ACES_X = 430;
-const int ACES_DX = 110;
+#include "assets/cards_png.hpp"
+#include "assets/outline_png.hpp"
 
 const float AI_MOVE_TIME = 1./5.;
+// How much of each frame the ai gets to think in
+const float AI_THINK_TIME = 1./120.;
 
-Game::Game(int draw) :
+const int HIGHLIGHT_THICKNESS = 4;
+
+Game::Game(RuleSet rules) :
     renderer(WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN),
-    cardTexture(renderer, "assets/cards.png"),
-    cardOutline(renderer, "assets/outline.png"),
+    cardTexture(renderer, CARDS_PIXELS, CARDS_WIDTH, CARDS_HEIGHT),
+    cardOutline(renderer, OUTLINE_PIXELS, OUTLINE_WIDTH, OUTLINE_HEIGHT),
     useAi(false),
-    cardDraw(draw)
-{}
+    board(rules),
+    rand(std::random_device{}())
+{
+    if (renderer.supports_targets()) {
+        boardLayer = Texture(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+}
 
-Game::Game(int draw, std::unique_ptr<SolitaireAI> ai) :
+Game::Game(RuleSet rules, std::unique_ptr<SolitaireAI> ai, bool safeMoves) :
     renderer(WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN),
-    cardTexture(renderer, "assets/cards.png"),
-    cardOutline(renderer, "assets/outline.png"),
+    cardTexture(renderer, CARDS_PIXELS, CARDS_WIDTH, CARDS_HEIGHT),
+    cardOutline(renderer, OUTLINE_PIXELS, OUTLINE_WIDTH, OUTLINE_HEIGHT),
     ai(std::move(ai)),
-    aiMoveTimer(0),
     useAi(true),
-    cardDraw(draw)
-{}
+    safeMoves(safeMoves),
+    board(rules),
+    rand(std::random_device{}())
+{
+    if (renderer.supports_targets()) {
+        boardLayer = Texture(renderer, WINDOW_WIDTH, WINDOW_HEIGHT);
+    }
+}
 
 bool is_hovering_card(std::pair<int, int> mousePos, std::pair<int, int> cardPos, int tolerance) {
     int mpx = mousePos.first;
@@ -68,212 +60,234 @@ bool is_hovering_card(std::pair<int, int> mousePos, std::pair<int, int> cardPos,
 }
 
 void Game::setup_game() {
-    for (int i = 0; i < 7; i++) {
-        playfield.at(i).clear();
-    }
-
-    pile.clear();
-    stock.clear();
+    // Whatever the ai was thinking was about the old board
+    thinking.reset();
+    board.deal(rand);
+    history.clear();
 
-    for (int i = 0; i < 4; i++) {
-        aces.at(i).clear();
+    if (ai) {
+        ai->forget();
     }
-
-    held = std::nullopt;
-
-    // populate the deck and shuffle it
-    stock.reserve(52);
-    for (int s = 0; s < 4; s++) {
-        for (int v = 0; v < 13; v++) {
-            Suit suit = static_cast<Suit>(s);
-            Value value = static_cast<Value>(v);
-
-            stock.push_back(Card(value, suit));
-        }
+    if (useAi && safeMoves) {
+        board.apply_safe_moves();
     }
+    held = std::nullopt;
+    boardDirty = true;
+}
 
-    std::mt19937 rand(std::random_device{}());
-    std::shuffle(stock.begin(), stock.end(), rand);
-
-    // Deal cards to the playfield
-    for (int i = 7; i >= 1; i--) {
-        for (int j = 7 - i; j < 7; j++) {
-            Card c = stock.back();
-            stock.pop_back();
-            c.upturned = j == 7 - i;
-            playfield.at(j).push_back(c);
-        }
-    }
+void Game::reseed(unsigned int seed) {
+    rand.seed(seed);
 }
 
-void Game::run() {
+void Game::run(EventTrace* recording) {
     setup_game();
 
+    if (!useAi) {
+        hints = std::make_unique<HintEngine>();
+    }
+
     bool exiting = false;
     Timer timer;
+    Timer sinceRecorded;
     SDL_Event e;
 
     while (!exiting) {
         mouse.update();
 
+        std::vector<SDL_Event> frameEvents;
         while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) {
-                exiting = true;
-            } if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_r) {
-                setup_game();
-            } else {
-                mouse.handle_input(e);
+            if (recording && is_recordable(e)) {
+                frameEvents.push_back(e);
             }
+
+            exiting |= handle_event(e);
+        }
+
+        if (recording && !frameEvents.empty()) {
+            Uint32 delta = static_cast<Uint32>(std::min(sinceRecorded.elapsed() * 1e6, double(UINT32_MAX)));
+            sinceRecorded.reset();
+            recording->frames.push_back(RecordedFrame { delta, std::move(frameEvents) });
         }
 
         float time = timer.elapsed();
         timer.reset();
+#ifdef BS_TRACING
+        frameGraph.push(time);
+#endif
         update(time);
         render();
     }
 }
 
-const Card& Game::get_card(CardSource src, std::pair<int, int> coord) {
-    switch (src) {
-        case CS_Pile:
-            if (pile.empty()) {
-                throw std::runtime_error("Pile is empty but get_card was called on it");
-            }
+ReplayStats Game::replay(const EventTrace& trace, bool render) {
+    ReplayStats stats {};
+    Timer timer;
 
-            return pile.back();
+    setup_game();
 
-        case CS_Playfield:
-            return playfield.at(coord.first).at(coord.second);
+    for (const RecordedFrame& frame : trace.frames) {
+        mouse.update();
 
-        case CS_Aces:
-            if (aces.at(coord.first).empty()) {
-                throw std::runtime_error(std::format("Aces pile {} empty but get_card was called on it", coord.first));
-            }
+        bool exiting = false;
+        for (const SDL_Event& e : frame.events) {
+            exiting |= handle_event(e);
+        }
 
-            return aces.at(coord.first).back();
-        default:
-            throw std::runtime_error("Invalid card source");
-    }
-}
+        update(static_cast<float>(frame.delta) / 1e6f);
 
-std::vector<Card> Game::pop_cards(CardSource src, std::pair<int, int> coord) {
-    std::vector<Card> res;
-    switch (src) {
-        case CS_Pile:
-            if (pile.empty()) {
-                throw std::runtime_error("Pile is empty but get_card was called on it");
-            }
+        if (render) {
+            this->render();
+        }
+
+        stats.frames++;
+        stats.events += frame.events.size();
 
-            res.push_back(pile.back());
-            pile.pop_back();
+        if (exiting) {
             break;
+        }
+    }
 
-        case CS_Playfield:
-            for (int i = coord.second; i < (int)playfield.at(coord.first).size(); i++) {
-                res.push_back(playfield.at(coord.first).at(i));
-            }
+    stats.seconds = timer.elapsed();
+    stats.solved = board.is_solved();
+    for (int i = 0; i < 4; i++) {
+        stats.foundationCards += board.aces.at(i).size();
+    }
 
-            playfield.at(coord.first).erase(playfield.at(coord.first).begin() + coord.second, playfield.at(coord.first).end());
+    return stats;
+}
 
-            if (!playfield.at(coord.first).empty()) {
-                playfield.at(coord.first).back().upturned = true;
+RenderBenchStats Game::bench_render(const std::vector<Board>& positions, int frames) {
+    RenderBenchStats stats;
+    stats.driver = renderer.driver_name();
+    useAi = false;
+
+    int framesEach = std::max(1, frames / std::max(static_cast<int>(positions.size()), 1));
+
+    for (size_t i = 0; i < positions.size(); i++) {
+        board = positions[i];
+        held = std::nullopt;
+        boardDirty = true;
+
+        // Pick up the run with the most face up cards in it, or the pile card if there aren't any
+        if (i % 2 == 1) {
+            int best = -1;
+            int bestFirstUp = 0;
+            for (int s = 0; s < 7; s++) {
+                const CardStack& stack = board.playfield.at(s);
+                int firstUp = stack.size();
+                while (firstUp > 0 && stack.at(firstUp - 1).upturned) {
+                    firstUp--;
+                }
+
+                if (firstUp < (int)stack.size() && (best < 0 || stack.size() - firstUp > board.playfield.at(best).size() - bestFirstUp)) {
+                    best = s;
+                    bestFirstUp = firstUp;
+                }
             }
-            break;
 
-        case CS_Aces:
-            if (aces.at(coord.first).empty()) {
-                throw std::runtime_error(std::format("Aces pile {} empty but get_card was called on it", coord.first));
+            if (best >= 0) {
+                held = HeldCard(board.playfield.at(best).at(bestFirstUp), { 20, 20 }, { best, bestFirstUp });
+            } else if (!board.pile.empty()) {
+                held = HeldCard(board.pile.back(), { 20, 20 });
             }
+        }
 
-            res.push_back(aces.at(coord.first).back());
-            aces.at(coord.first).pop_back();
+        for (int f = 0; f < framesEach; f++) {
+            // Sweep the mouse back and forth across the window
+            SDL_Event motion {};
+            motion.type = SDL_MOUSEMOTION;
+            motion.motion.x = 50 + (f * 13) % (WINDOW_WIDTH - 100);
+            motion.motion.y = 50 + (f * 7) % (WINDOW_HEIGHT - 100);
+            mouse.handle_input(motion);
+
+            bool redrawn = boardDirty || boardLayer.inner() == nullptr;
+            uint64_t callsBefore = renderer.draw_calls();
+            Timer timer;
+            render();
+
+            stats.frameSeconds.push_back(timer.elapsed());
+            stats.frameDrawCalls.push_back(renderer.draw_calls() - callsBefore);
+            stats.frameRedrawn.push_back(redrawn);
+            stats.dragFrames += held.has_value();
+        }
     }
 
-    return res;
+    return stats;
 }
 
-bool Game::is_solved() {
-    bool all_upturned = true;
-
-    for (int i = 0; i < 7; i++) {
-        for (auto c = playfield.at(i).begin(); c != playfield.at(i).end(); c++) {
-            all_upturned &= c->upturned;
-        }
+bool Game::handle_event(const SDL_Event& e) {
+    if (e.type == SDL_QUIT) {
+        return true;
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_r) {
+        setup_game();
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_h) {
+        showHint = !showHint;
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_z && !useAi && !held) {
+        boardDirty |= history.undo(board);
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_y && !useAi && !held) {
+        boardDirty |= history.redo(board);
+    } else if (e.type == SDL_RENDER_TARGETS_RESET) {
+        // The contents of target textures are lost when this happens
+        boardDirty = true;
+#ifdef BS_TRACING
+    } else if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_F3) {
+        frameGraph.visible = !frameGraph.visible;
+#endif
+    } else {
+        mouse.handle_input(e);
     }
 
-    return pile.size() == 0 && stock.size() == 0 && all_upturned;
+    return false;
 }
 
 void Game::run_ai() {
+    TRACE_SCOPE("run_ai");
+
     if (!useAi) {
         throw std::runtime_error("runAi called but ai is not being used");
     }
 
-    std::optional<SolitaireMove> move = ai->nextMove(playfield, pile, aces);
-
-    if (!move) {
-        return;
+    if (!thinking) {
+        thinking = ai->think(board);
     }
 
-    if (std::holds_alternative<CyclePile>(*move)) {
-        deal_or_reset_stock();
-    } else if (std::holds_alternative<MoveToStack>(*move)) {
-        MoveToStack m = std::get<MoveToStack>(*move);
-        const Card& selectedCard = get_card(m.source, m.fromCoord);
-
-        if (selectedCard.value == King) {
-            if (!playfield.at(m.toStackId).empty()) {
-                throw std::runtime_error("Ai tried to move a king to a nonempty space");
-            }
-        } else if (playfield.at(m.toStackId).empty() || !selectedCard.can_be_placed_on(playfield.at(m.toStackId).back())) {
-            throw std::runtime_error("Ai tried to place a card on a card that it cant go on");
-        }
+    {
+        TRACE_SCOPE("think");
+        Timer thinkTimer;
+        while (thinkTimer.elapsed() < AI_THINK_TIME && thinking->resume()) {}
+    }
 
-        std::vector<Card> cards = pop_cards(m.source, m.fromCoord);
-        for (auto c = cards.begin(); c != cards.end(); c++) {
-            playfield.at(m.toStackId).push_back(*c);
-        }
-    } else if (std::holds_alternative<MoveToAces>(*move)) {
-        MoveToAces m = std::get<MoveToAces>(*move);
-        const Card& selectedCard = get_card(m.source, m.fromCoord);
+    // The ai keeps thinking until it's done or it's been AI_MOVE_TIME since its last move
+    bool timeToMove = aiMoveTimer.elapsed() >= AI_MOVE_TIME;
+    if (!timeToMove || (!thinking->done() && !thinking->best())) {
+        return;
+    }
 
-        if (selectedCard.value == Ace) {
-            if (!aces.at(m.toAcesId).empty()) {
-                throw std::runtime_error("Ai tried to put an ace on a non-empty ace space");
-            }
-        } else if (aces.at(m.toAcesId).empty()
-                || static_cast<int>(selectedCard.value) != static_cast<int>(aces.at(m.toAcesId).back().value) + 1
-                || selectedCard.suit != aces.at(m.toAcesId).back().suit)
-        {
-            throw std::runtime_error(std::format(
-                "Ai tried to put a card in an ace space where it cant go. card value: {}, suit: {}",
-                static_cast<int>(selectedCard.value),
-                static_cast<int>(selectedCard.suit)
-            ));
-        }
+    std::optional<SolitaireMove> move = thinking->best();
+    // It was thinking about the board we're about to change
+    thinking.reset();
+    aiMoveTimer.reset();
 
-        std::vector<Card> cards = pop_cards(m.source, m.fromCoord);
-        if (cards.size() != 1) {
-            throw std::runtime_error("Ai played an invalid move!");
-        }
+    if (!move) {
+        return;
+    }
 
-        aces.at(m.toAcesId).push_back(cards[0]);
+    boardDirty = true;
+    board.apply_move(*move);
+    if (safeMoves) {
+        board.apply_safe_moves();
     }
 }
 
-void Game::update(float dt) {
+void Game::update(float /* dt */) {
+    TRACE_SCOPE("update");
+
     if (useAi) {
-        if (is_solved()) {
+        if (board.is_solved()) {
             return;
         }
 
-        aiMoveTimer += dt;
-
-        if (true) {
-            aiMoveTimer -= AI_MOVE_TIME;
-    
-            run_ai();
-        }
+        run_ai();
     }
 
     else {
@@ -281,95 +295,67 @@ void Game::update(float dt) {
             // Check if the stock was pressed
             auto mp = mouse.pos();
             if (is_hovering_card(mp, { STOCK_X, STOCK_PILE_Y }, 0)) {
-                deal_or_reset_stock();
+                if (board.can_cycle()) {
+                    make_player_move(CyclePile {});
+                }
             }
 
             else if (!held) {
                 // Check to see if the player picked up a new card
                 std::optional<HeldCard> newHeld = get_hovered_card(0);
                 held = newHeld;
+                boardDirty |= held.has_value();
             }
         }
 
         else if (mouse.is_just_released(1)) {
             if (held) {
-                std::optional<HeldCard> hovered = get_hovered_card(5);
-
-                // If we are hovering over a stack card, we should try to place the card on that stack
-                if (hovered && hovered->stackCoord && hovered->stackCoord->second == (int)playfield.at(hovered->stackCoord->first).size() - 1) {
-                    std::vector<Card>& stack = playfield.at(hovered->stackCoord->first);
-                    // important that c isn't a reference bc we'll be modifying stack later and we don't want it to be invalidated
-                    // c++ moment!
-                    Card c = stack.back();
-
-                    if (held->c.can_be_placed_on(c)) {
-                        if (held->stackCoord) {
-                            // If the held card is from a stack, we need to place all the cards that were below it too
-                            std::vector<Card>& fromStack = playfield.at(held->stackCoord->first);
-
-                            for (int j = held->stackCoord->second; j < (int)fromStack.size(); j++) {
-                                stack.push_back(fromStack.at(j));
-                            }
-
-                            pop_held_cards();
-                        } else {
-                            // If it was from the pile, just place the card
-                            stack.push_back(pile.back());
-                            pop_held_cards();
-                        }
-                    }
-                } else if (auto acesId = get_hovered_aces_id(5); acesId) {
-                    bool canBePlaced = (held->c.value == Ace && aces.at(*acesId).empty())
-                        || (!aces.at(*acesId).empty()
-                                && static_cast<int>(aces.at(*acesId).back().value) == static_cast<int>(held->c.value) - 1
-                                && aces.at(*acesId).back().suit == held->c.suit);
-
-                    if (canBePlaced) {
-                        aces.at(*acesId).push_back(held->c);
-                        pop_held_cards();
-                    }
-                } else if (auto emptyId = get_hovered_empty_id(5); emptyId && held->c.value == King) {
-                    if (!playfield.at(*emptyId).empty()) {
-                        throw std::runtime_error("Stack not empty but it should be");
-                    }
-
-                    if (held->stackCoord) {
-                        std::vector<Card>& fromStack = playfield.at(held->stackCoord->first);
-
-                        for (int j = held->stackCoord->second; j < (int)fromStack.size(); j++) {
-                            playfield.at(*emptyId).push_back(fromStack.at(j));
-                        }
-                    } else {
-                        playfield.at(*emptyId).push_back(held->c);
-                    }
-
-                    pop_held_cards();
+                if (std::optional<SolitaireMove> move = dropped_move()) {
+                    make_player_move(*move);
                 }
 
                 held = std::nullopt;
+                boardDirty = true;
             }
         }
+
+        // Whatever the hint engine was working on is out of date once anything's moved
+        if (hints && board.state_hash() != hintedHash) {
+            hintedHash = board.state_hash();
+            hints->set_position(board);
+            showHint = false;
+        }
     }
 }
 
-void Game::pop_held_cards() {
-    if (held->stackCoord) {
-        if (playfield.at(held->stackCoord->first).empty()) {
-            throw std::runtime_error("Stack should not be empty rn");
-        }
+void Game::make_player_move(const SolitaireMove& move) {
+    history.apply(board, move);
+    // The cached board layer has to be redrawn after anything that changes the board
+    boardDirty = true;
+}
 
-        std::vector<Card>& stack = playfield.at(held->stackCoord->first);
-        stack.erase(stack.begin() + held->stackCoord->second, stack.end());
+// The move the player makes by letting go of the held cards where they are, if it's a legal one
+std::optional<SolitaireMove> Game::dropped_move() {
+    CardSource source = held->stackCoord ? CS_Playfield : CS_Pile;
+    std::pair<int, int> from = held->stackCoord.value_or(std::pair(0, 0));
+    std::optional<HeldCard> hovered = get_hovered_card(5);
 
-        if (!stack.empty() && !stack.back().upturned) {
-            stack.back().upturned = true;
+    // If we are hovering over a stack card, we should try to place the card on that stack
+    if (hovered && hovered->stackCoord && hovered->stackCoord->second == (int)board.playfield.at(hovered->stackCoord->first).size() - 1) {
+        if (held->c.can_be_placed_on(hovered->c)) {
+            return MoveToStack { source, from, hovered->stackCoord->first };
         }
-    } else {
-        if (pile.empty()) {
-            throw std::runtime_error("Stack should not be empty rn");
+    } else if (auto acesId = get_hovered_aces_id(5); acesId) {
+        // Only one card at a time goes up on the aces
+        bool single = !held->stackCoord || held->stackCoord->second == (int)board.playfield.at(held->stackCoord->first).size() - 1;
+        if (single && can_go_on_aces(held->c, board.aces.at(*acesId))) {
+            return MoveToAces { source, from, *acesId };
         }
-        pile.pop_back();
+    } else if (auto emptyId = get_hovered_empty_id(5); emptyId && held->c.value == King) {
+        return MoveToStack { source, from, *emptyId };
     }
+
+    return std::nullopt;
 }
 
 std::optional<int> Game::get_hovered_aces_id(int tolerance) {
@@ -391,7 +377,7 @@ std::optional<int> Game::get_hovered_empty_id(int tolerance) {
     auto mp = mouse.pos();
 
     for (int i = 0; i < 7; i++) {
-        if (!playfield.at(i).empty()) {
+        if (!board.playfield.at(i).empty()) {
             continue;
         }
 
@@ -410,18 +396,18 @@ std::optional<HeldCard> Game::get_hovered_card(int tolerance) {
     auto mp = mouse.pos();
 
     // Check if we are hovering over the pile card
-    if (!pile.empty()) {
-        int pile_x = PILE_X + (std::min((int)pile.size(), 3) - 1) * PILE_DX;
+    if (!board.pile.empty()) {
+        int pile_x = PILE_X + (std::min((int)board.pile.size(), 3) - 1) * PILE_DX;
         int pile_y = STOCK_PILE_Y;
 
         if (is_hovering_card(mp, { pile_x, pile_y }, tolerance)) {
-            return HeldCard(pile.back(), { mp.first - pile_x, mp.second - pile_y });
+            return HeldCard(board.pile.back(), { mp.first - pile_x, mp.second - pile_y });
         }
     }
 
     // Check the stacks
     for (int i = 0; i < 7; i++) {
-        std::vector<Card>& stack = playfield.at(i);
+        CardStack& stack = board.playfield.at(i);
         if (stack.empty()) {
             continue;
         }
@@ -451,7 +437,7 @@ std::optional<HeldCard> Game::get_hovered_card(int tolerance) {
 // i.e., the height of the "covered card" section
 int Game::stack_height(int i) {
     int height = 0;
-    std::vector<Card>& stack = playfield.at(i);
+    CardStack& stack = board.playfield.at(i);
 
     for (unsigned int j = 0; j < stack.size() - 1; j++) {
         Card& c = stack.at(j);
@@ -465,29 +451,35 @@ int Game::stack_height(int i) {
     return height;
 }
 
-void Game::deal_or_reset_stock() {
-    if (stock.empty()) {
-        // Move cards from the pile to the stock
-        while (!pile.empty()) {
-            Card c = pile.back();
-            pile.pop_back();
-            stock.push_back(c);
-        }
-    } else {
-        // Deal up to 3 cards
-        for (int i = 0; i < cardDraw; i++) {
-            if (stock.empty()) {
-                break;
-            }
+void Game::render() {
+    TRACE_SCOPE("render");
 
-            Card c = stock.back();
-            stock.pop_back();
-            pile.push_back(c);
+    if (boardLayer.inner() == nullptr) {
+        // No render target support, so just draw everything every frame
+        render_board();
+    } else {
+        if (boardDirty) {
+            renderer.set_target(&boardLayer);
+            render_board();
+            renderer.set_target(nullptr);
+            boardDirty = false;
         }
+
+        renderer.draw_texture(boardLayer, 0, 0);
+    }
+
+    if (showHint) {
+        render_hint();
     }
+
+    render_held();
+#ifdef BS_TRACING
+    frameGraph.render(renderer);
+#endif
+    renderer.present();
 }
 
-void Game::render() {
+void Game::render_board() {
     renderer.set_draw_colour(0x34, 0xC9, 0x70, 0xFF);
     renderer.clear();
 
@@ -495,7 +487,7 @@ void Game::render() {
     for (int i = 0; i < 7; i++) {
         int x = PLAYFIELD_START_X + i * PLAYFIELD_CARD_DX;
         int y = PLAYFIELD_START_Y;
-        std::vector<Card>& stack = playfield.at(i);
+        CardStack& stack = board.playfield.at(i);
 
         for (int j = 0; j < (int)stack.size(); j++) {
             Card& c = stack.at(j);
@@ -515,19 +507,19 @@ void Game::render() {
     }
 
     // Render the stock and pile
-    if (!stock.empty()) {
+    if (!board.stock.empty()) {
         render_card_back(STOCK_X, STOCK_PILE_Y);
     } else {
         render_card_outline(STOCK_X, STOCK_PILE_Y);
     }
 
     // Render the pile
-    if (!pile.empty()) {
+    if (!board.pile.empty()) {
         if (held && !held->stackCoord) {
-            if (pile.size() > 1) {
+            if (board.pile.size() > 1) {
                 int x = PILE_X;
-                for (int i = std::min((int)pile.size() - 1, 2); i > 0; i--) {
-                    render_card(pile.at(pile.size() - i - 1), x, STOCK_PILE_Y);
+                for (int i = std::min((int)board.pile.size() - 1, 2); i > 0; i--) {
+                    render_card(board.pile.at(board.pile.size() - i - 1), x, STOCK_PILE_Y);
                     x += PILE_DX;
                 }
             } else {
@@ -535,8 +527,8 @@ void Game::render() {
             }
         } else {
             int x = PILE_X;
-            for (int i = std::min((int)pile.size(), 3); i > 0; i--) {
-                render_card(pile.at(pile.size() - i), x, STOCK_PILE_Y);
+            for (int i = std::min((int)board.pile.size(), 3); i > 0; i--) {
+                render_card(board.pile.at(board.pile.size() - i), x, STOCK_PILE_Y);
                 x += PILE_DX;
             }
         }
@@ -544,58 +536,39 @@ void Game::render() {
 
     // Render the ace stacks
     for (int i = 0; i < 4; i++) {
-        if (aces.at(i).empty()) {
+        if (board.aces.at(i).empty()) {
             render_card_outline(ACES_X + i * ACES_DX, STOCK_PILE_Y);
         } else {
-            render_card(aces.at(i).back(), ACES_X + i * ACES_DX, STOCK_PILE_Y);
+            render_card(board.aces.at(i).back(), ACES_X + i * ACES_DX, STOCK_PILE_Y);
         }
     }
+}
 
-    // Render the held card
+void Game::render_held() {
     if (held) {
         auto mp = mouse.pos();
         int x = mp.first - held->mouseOffset.first;
         int y = mp.second - held->mouseOffset.second;
 
         if (held->stackCoord) {
-            std::vector<Card>& stack = playfield.at(held->stackCoord->first);
+            CardStack& stack = board.playfield.at(held->stackCoord->first);
 
             for (int j = held->stackCoord->second; j < (int)stack.size(); j++) {
                 render_card(stack.at(j), x, y + (j - held->stackCoord->second) * PLAYFIELD_UP_CARD_DY);
             }
         } else {
             // Card is from the pile
-            if (pile.empty()) {
+            if (board.pile.empty()) {
                 throw std::runtime_error("Pile is empty but held card is from the pile?");
             }
 
-            render_card(pile.back(), x, y);
+            render_card(board.pile.back(), x, y);
         }
     }
-
-    renderer.present();
-}
-
-SDL_Rect get_rect_for_tile(const std::pair<int, int>& coord) {
-    SDL_Rect res;
-    res.x = coord.first * CARD_TILE_WIDTH + CARD_TILE_OFFSET_X;
-    res.y = coord.second * CARD_TILE_HEIGHT + CARD_TILE_OFFSET_Y;
-    res.w = CARD_SPRITE_WIDTH;
-    res.h = CARD_SPRITE_HEIGHT;
-
-    return res;
-}
-
-std::pair<int, int> card_tilesheet_coord(const Card& card) {
-    return { static_cast<int>(card.value), static_cast<int>(card.suit) };
-}
-
-SDL_Rect get_rect_for_card(const Card& card) {
-    return get_rect_for_tile(card_tilesheet_coord(card));
 }
 
 void Game::render_card(const Card& card, int x, int y) {
-    SDL_Rect srcRect = get_rect_for_card(card);
+    SDL_Rect srcRect = CARD_SPRITE_RECTS[card.index()];
     SDL_Rect dstRect;
     dstRect.x = x;
     dstRect.y = y;
@@ -605,7 +578,7 @@ void Game::render_card(const Card& card, int x, int y) {
 }
 
 void Game::render_card_back(int x, int y) {
-    SDL_Rect srcRect = get_rect_for_tile({ 13, 1 });
+    SDL_Rect srcRect = CARD_SPRITE_RECTS[CARD_BACK_SPRITE];
     SDL_Rect dstRect;
     dstRect.x = x;
     dstRect.y = y;
@@ -622,3 +595,68 @@ void Game::render_card_outline(int x, int y) {
     dstRect.h = CARD_SPRITE_HEIGHT * CARD_UPSCALE;
     renderer.draw_texture(cardOutline, std::nullopt, dstRect);
 }
+
+std::pair<int, int> Game::card_pos(CardSource source, std::pair<int, int> coord) {
+    switch (source) {
+        case CS_Pile:
+            return { PILE_X + (std::min((int)board.pile.size(), 3) - 1) * PILE_DX, STOCK_PILE_Y };
+        case CS_Aces:
+            return { ACES_X + coord.first * ACES_DX, STOCK_PILE_Y };
+        default: {
+            const CardStack& stack = board.playfield.at(coord.first);
+            int y = PLAYFIELD_START_Y;
+            for (int j = 0; j < coord.second; j++) {
+                y += stack.at(j).upturned ? PLAYFIELD_UP_CARD_DY : PLAYFIELD_DOWN_CARD_DY;
+            }
+            return { PLAYFIELD_START_X + coord.first * PLAYFIELD_CARD_DX, y };
+        }
+    }
+}
+
+void Game::render_hint() {
+    std::optional<Hint> hint = hints ? hints->hint() : std::nullopt;
+    if (!hint) {
+        return;
+    }
+
+    // Gold if it's part of a winning line, red if there isn't one, and white if we don't know yet
+    if (hint->verdict == SR_Win) {
+        renderer.set_draw_colour(0xFF, 0xD7, 0x00, 0xFF);
+    } else if (hint->verdict == SR_Loss) {
+        renderer.set_draw_colour(0xE0, 0x30, 0x30, 0xFF);
+    } else {
+        renderer.set_draw_colour(0xFF, 0xFF, 0xFF, 0xFF);
+    }
+
+    if (std::holds_alternative<CyclePile>(hint->move)) {
+        render_highlight(STOCK_X, STOCK_PILE_Y);
+    } else if (const MoveToStack* m = std::get_if<MoveToStack>(&hint->move)) {
+        auto [fromX, fromY] = card_pos(m->source, m->fromCoord);
+        render_highlight(fromX, fromY);
+
+        const CardStack& to = board.playfield.at(m->toStackId);
+        if (to.empty()) {
+            render_highlight(PLAYFIELD_START_X + m->toStackId * PLAYFIELD_CARD_DX, PLAYFIELD_START_Y);
+        } else {
+            auto [toX, toY] = card_pos(CS_Playfield, { m->toStackId, (int)to.size() - 1 });
+            render_highlight(toX, toY);
+        }
+    } else if (const MoveToAces* m = std::get_if<MoveToAces>(&hint->move)) {
+        auto [fromX, fromY] = card_pos(m->source, m->fromCoord);
+        render_highlight(fromX, fromY);
+        render_highlight(ACES_X + m->toAcesId * ACES_DX, STOCK_PILE_Y);
+    }
+}
+
+// A frame around the card at (x, y), in the current draw colour
+void Game::render_highlight(int x, int y) {
+    int width = CARD_SPRITE_WIDTH * CARD_UPSCALE + 2 * HIGHLIGHT_THICKNESS;
+    int height = CARD_SPRITE_HEIGHT * CARD_UPSCALE + 2 * HIGHLIGHT_THICKNESS;
+    x -= HIGHLIGHT_THICKNESS;
+    y -= HIGHLIGHT_THICKNESS;
+
+    renderer.fill_rect({ x, y, width, HIGHLIGHT_THICKNESS });
+    renderer.fill_rect({ x, y + height - HIGHLIGHT_THICKNESS, width, HIGHLIGHT_THICKNESS });
+    renderer.fill_rect({ x, y, HIGHLIGHT_THICKNESS, height });
+    renderer.fill_rect({ x + width - HIGHLIGHT_THICKNESS, y, HIGHLIGHT_THICKNESS, height });
+}
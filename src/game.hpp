@@ -3,11 +3,19 @@
 #include <array>
 #include <SDL.h>
 #include <memory>
+#include <random>
 #include <vector>
 #include "sdl_wrapper.hpp"
 #include "ai/ai.hpp"
+#include "ai/hint_engine.hpp"
+#include "board.hpp"
 #include "cards.hpp"
+#include "frame_graph.hpp"
+#include "history.hpp"
 #include "input.hpp"
+#include "render_bench.hpp"
+#include "replay.hpp"
+#include "utils.hpp"
 
 struct HeldCard {
     Card c;
@@ -26,13 +34,25 @@ struct HeldCard {
 };
 
 struct Game {
-    Game(int draw);
-    Game(int draw, std::unique_ptr<SolitaireAI> ai);
+    Game(RuleSet rules);
+    // The ai plays instead of the player. If safeMoves is set, the safe moves (see
+    // Board::apply_safe_moves) are made for it after every move, the same as in the benchmark.
+    Game(RuleSet rules, std::unique_ptr<SolitaireAI> ai, bool safeMoves = false);
 
     void setup_game();
-    void run();
+    // Seeds the rng used to shuffle the deck, so the following deals are reproducible
+    void reseed(unsigned int seed);
+    // Runs the game in a window until it is closed. If recording isn't null, all the input
+    // events are saved into it.
+    void run(EventTrace* recording = nullptr);
+    // Plays back a recorded session as fast as possible, optionally rendering every frame
+    ReplayStats replay(const EventTrace& trace, bool render);
+    // Renders each of the positions for an equal share of the frames and times every frame.
+    // On every other position the longest face up run on the board gets dragged around the
+    // window the whole time.
+    RenderBenchStats bench_render(const std::vector<Board>& positions, int frames);
+    // Lets the ai think for a bit, and makes its move once it's time to
     void run_ai();
-    bool is_solved();
 
 private:
     Renderer renderer;
@@ -41,38 +61,64 @@ private:
     Texture cardTexture;
     Texture cardOutline;
 
+    // Everything on the board except the held cards, redrawn only when boardDirty is set.
+    // This way dragging a card around only costs a couple of blits per frame
+    Texture boardLayer;
+    bool boardDirty = true;
+
+#ifdef BS_TRACING
+    FrameGraph frameGraph;
+#endif
+
     // The ai, if any
     std::unique_ptr<SolitaireAI> ai;
-    float aiMoveTimer = 0;
+    // Time since the ai last moved
+    Timer aiMoveTimer;
+    // What the ai is thinking about the current board, if it's started
+    std::optional<Thinking> thinking;
     bool useAi;
+    bool safeMoves = false;
+
+    // Hints for the player, worked out in the background from whatever the board is now. Only
+    // started for interactive games, so replays and benchmarks don't pay for it.
+    std::unique_ptr<HintEngine> hints;
+    // The board the hint engine was last told about
+    uint64_t hintedHash = 0;
+    bool showHint = false;
 
     // Event tracking
     MouseState mouse;
 
     // Game model
-    std::array<std::vector<Card>, 7> playfield;
-    std::array<std::vector<Card>, 4> aces;
-    std::vector<Card> stock;
-    std::vector<Card> pile;
+    Board board;
+    // Every move the player's made this game, for undo (z) and redo (y)
+    History history;
     std::optional<HeldCard> held;
-    int cardDraw;
+    std::mt19937 rand;
 
+    // Returns true if the game should exit
+    bool handle_event(const SDL_Event& e);
     void update(float dt);
     void render();
+    void render_board();
+    void render_held();
     void render_card(const Card& card, int x, int y);
     void render_card_back(int x, int y);
     void render_card_outline(int x, int y);
+    void render_hint();
+    void render_highlight(int x, int y);
+
+    // Where the card is drawn on screen (the top left corner)
+    std::pair<int, int> card_pos(CardSource source, std::pair<int, int> coord);
 
     std::optional<HeldCard> get_hovered_card(int tolerance);
     std::optional<int> get_hovered_aces_id(int tolerance);
     std::optional<int> get_hovered_empty_id(int tolerance);
 
-    const Card& get_card(CardSource src, std::pair<int, int> coord);
-    std::vector<Card> pop_cards(CardSource src, std::pair<int, int> coord);
-
-    void pop_held_cards();
+    std::optional<SolitaireMove> dropped_move();
+    // Makes the move (which has to be legal) for the player, so it can be undone, and marks the
+    // board for redrawing
+    void make_player_move(const SolitaireMove& move);
 
     int stack_height(int i);
-
-    void deal_or_reset_stock();
 };
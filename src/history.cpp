@@ -0,0 +1,33 @@
+#include "history.hpp"
+
+void History::apply(Board& board, const SolitaireMove& move) {
+    done.push_back(board.apply_move(move));
+    undone.clear();
+}
+
+bool History::undo(Board& board) {
+    if (done.empty()) {
+        return false;
+    }
+
+    board.undo_move(done.back());
+    undone.push_back(done.back().move);
+    done.pop_back();
+    return true;
+}
+
+bool History::redo(Board& board) {
+    if (undone.empty()) {
+        return false;
+    }
+
+    // The board is back how it was when this was first made, so it does the same thing again
+    done.push_back(board.apply_move(undone.back()));
+    undone.pop_back();
+    return true;
+}
+
+void History::clear() {
+    done.clear();
+    undone.clear();
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+#include "board.hpp"
+
+// Undo and redo for one board. Only the MoveRecords are kept, never copies of the board, so it
+// costs a few bytes per move however long the game goes on, and undoing or redoing a move is as
+// cheap as making it.
+//
+// Search ais can use it to back out of a line too, rather than copying the board at every step.
+class History {
+public:
+    // Makes the move on the board and remembers it. Anything that could have been redone is
+    // forgotten, like in every other program with undo.
+    void apply(Board& board, const SolitaireMove& move);
+    // Both return false if there was nothing to undo (or redo)
+    bool undo(Board& board);
+    bool redo(Board& board);
+    // Forgets everything, e.g. for a new deal
+    void clear();
+
+    bool can_undo() const { return !done.empty(); }
+    bool can_redo() const { return !undone.empty(); }
+
+private:
+    std::vector<MoveRecord> done;
+    // Most recently undone last
+    std::vector<SolitaireMove> undone;
+};
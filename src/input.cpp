@@ -11,8 +11,12 @@ void MouseState::handle_input(const SDL_Event& e) {
         if (auto pair = buttons.insert({ e.button.button, std::pair(false, pressed) }); !pair.second) {
             pair.first->second.second = pressed;
         }
+
+        position = { e.button.x, e.button.y };
     } else if (e.type == SDL_MOUSEMOTION) {
-        SDL_GetMouseState(&position.first, &position.second);
+        // Read the position from the event rather than SDL_GetMouseState so that replayed
+        // events (see replay.hpp) move the mouse too
+        position = { e.motion.x, e.motion.y };
     }
 }
 
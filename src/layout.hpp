@@ -0,0 +1,56 @@
+#pragma once
+
+#include <SDL.h>
+#include <array>
+#include <utility>
+#include "cards.hpp"
+
+// Where everything goes on screen, and where each card is in assets/cards.png. Shared by the game
+// and the spectator wall (see watch.hpp).
+
+const int WINDOW_WIDTH = 900;
+const int WINDOW_HEIGHT = 800;
+
+const int CARD_TILE_WIDTH = 64;
+const int CARD_TILE_HEIGHT = 64;
+const int CARD_TILE_OFFSET_X = 11;
+const int CARD_TILE_OFFSET_Y = 2;
+const int CARD_SPRITE_WIDTH = 42;
+const int CARD_SPRITE_HEIGHT = 60;
+const int CARD_UPSCALE = 2;
+
+const int PLAYFIELD_START_X = 100;
+const int PLAYFIELD_START_Y = 200;
+const int PLAYFIELD_CARD_DX = 110;
+const int PLAYFIELD_UP_CARD_DY = 30;
+const int PLAYFIELD_DOWN_CARD_DY = 15;
+
+const int STOCK_X = 100;
+const int PILE_X = 210;
+const int PILE_DX = 30;
+const int STOCK_PILE_Y = 50;
+
+const int ACES_X = 430;
+const int ACES_DX = 110;
+
+constexpr SDL_Rect get_rect_for_tile(const std::pair<int, int>& coord) {
+    return SDL_Rect {
+        coord.first * CARD_TILE_WIDTH + CARD_TILE_OFFSET_X,
+        coord.second * CARD_TILE_HEIGHT + CARD_TILE_OFFSET_Y,
+        CARD_SPRITE_WIDTH,
+        CARD_SPRITE_HEIGHT,
+    };
+}
+
+// Where each card is on the tilesheet, indexed by Card::index(). The last entry is the card back.
+const int CARD_BACK_SPRITE = 52;
+constexpr std::array<SDL_Rect, 53> CARD_SPRITE_RECTS = [] {
+    std::array<SDL_Rect, 53> rects {};
+    for (int s = 0; s < 4; s++) {
+        for (int v = 0; v < 13; v++) {
+            rects[card_index(static_cast<Value>(v), static_cast<Suit>(s))] = get_rect_for_tile({ v, s });
+        }
+    }
+    rects[CARD_BACK_SPRITE] = get_rect_for_tile({ 13, 1 });
+    return rects;
+}();
@@ -1,37 +1,399 @@
 #include <SDL.h>
-#include <SDL_image.h>
+#include <algorithm>
+#include <charconv>
 #include <cstring>
 #include <iostream>
 #include <print>
+#include <random>
+#include "args.hpp"
 #include "game.hpp"
+#include "render_bench.hpp"
+#include "replay.hpp"
+#include "rules.hpp"
+#include "rules_fuzz.hpp"
+#include "watch.hpp"
+#include "notation.hpp"
+#include "ai/analyze.hpp"
 #include "ai/benchmark.hpp"
-#include "ai/pippin.hpp"
-#include "src/ai/ai.hpp"
-#include "src/ai/dennis.hpp"
+#include "ai/compare.hpp"
+#include "src/ai/factory.hpp"
+#include "src/ai/solver.hpp"
+#include "src/ai/tune.hpp"
 
-int main(int argc, char **argv) {
-    if (argc == 3 && !std::strcmp(argv[1], "benchmark")) {
-        std::unique_ptr<SolitaireAI> ai;
-
-        if (!std::strcmp(argv[2], "dennis")) {
-            ai = std::make_unique<Dennis>();
-        } else if (!std::strcmp(argv[2], "pippin")) {
-            ai = std::make_unique<Pippin>();
-        } else {
-            std::cerr << "Not a valid ai name: \"" << argv[2] << "\"" << std::endl;
+void print_usage() {
+    std::println("Usage: bs [RULES]");
+    std::println("       bs benchmark [AI_NAME] [RULES] [AI_OPTIONS] [--games N] [--threads N] [--seed N]");
+    std::println("                    [--precision P] [--compare-against RATE|FILE] [--save-baseline FILE]");
+    std::println("       bs compare AI_NAME AI_NAME... [RULES] [AI_OPTIONS] [--games N] [--threads N] [--seed N]");
+    std::println("       bs tune dennis [RULES] [--dennis-params FILE] [--games N] [--rounds N] [--candidates N]");
+    std::println("                      [--threads N] [--seed N] [--out FILE]");
+    std::println("       bs analyze AI_NAME [RULES] [AI_OPTIONS] [--threads N] [--playouts N] < BOARDS");
+    std::println("       bs deal [--games N] [--seed N]");
+    std::println("       bs solve [RULES] [--games N] [--threads N] [--seed N] [--nodes N] [--cache FILE]");
+    std::println("       bs play AI_NAME [RULES] [--width N] [--depth N] [--dennis-params FILE] [--safe-moves]");
+    std::println("       bs watch AI_NAME [RULES] [--width N] [--depth N] [--dennis-params FILE] [--safe-moves]");
+    std::println("                [--grid COLUMNSxROWS] [--speed N] [--seed N]");
+    std::println("       bs bench-render [RULES] [--frames N] [--positions N] [--seed N]");
+    std::println("                        [--positions-file FILE]");
+    std::println("       bs fuzz [RULES] [--games N] [--steps N] [--threads N] [--seed N] [--out FILE]");
+    std::println("       bs fuzz --replay FILE");
+    std::println("       bs record [TRACE_FILE] [RULES]");
+    std::println("       bs replay [TRACE_FILE] [--render]");
+    std::println("\nwhere RULES are any of:");
+    std::println("  --draw 1|3                 cards dealt from the stock at a time (default 3)");
+    std::println("  --passes 1|3|unlimited     times you can go through the stock (default unlimited)");
+    std::println("  --no-foundation-return     don't allow moving cards back down from the aces");
+    std::println("\nand AI_OPTIONS are any of:");
+    std::println("  --width N                  positions bea keeps at each depth (default {})", BeamOptions{}.width);
+    std::println("  --depth N                  moves bea looks ahead (default {})", BeamOptions{}.depth);
+    std::println("  --dennis-params FILE       play dennis with the parameters from `bs tune dennis`");
+    std::println("  --ms-per-move N            let the ai think for this long every move");
+    std::println("  --nodes-per-move N         let the ai look at this many positions every move");
+    std::println("  --safe-moves               put cards on the aces for the ai when it's always safe to");
+    std::println("\ncompare and fuzz also take lists like \"--draw 1,3\" and run every combination.");
+    std::println("benchmark stops early once the win rate is known to +-P (e.g. 0.5%), or once it's clearly");
+    std::println("better or worse than (or within P of) a baseline win rate, given as e.g. 7.5% or a file");
+    std::println("from --save-baseline. A saved win rate is only a sample, so the test allows for its 95% interval,");
+    std::println("and it has to have been measured under the same rules.");
+    std::println("watch makes --speed moves a second on every board (default {}).", WatchOptions{}.movesPerSecond);
+    std::println("analyze plays each position out --playouts times, which only makes sense for an ai with random");
+    std::println("choices (so not bea).");
+    std::println("\nthe ais to choose from right now are {}.", AI_NAMES);
+}
+
+// The options each command understands, for Args::expect
+const std::vector<std::string_view> RULE_OPTIONS = { "draw", "passes", "no-foundation-return" };
+const std::vector<std::string_view> AI_OPTIONS = {
+    "width", "depth", "dennis-params", "ms-per-move", "nodes-per-move", "safe-moves"
+};
+
+RuleSet parse_rule_set(const std::string& draw, const std::string& passes, bool foundationReturn) {
+    RuleSet rules;
+    rules.draw = parse_int("draw", draw);
+    rules.passes = passes == "unlimited" ? 0 : parse_int("passes", passes);
+    rules.foundationReturn = foundationReturn;
+
+    if (!is_supported(rules)) {
+        throw std::runtime_error(std::format("These rules aren't supported: {}", describe(rules)));
+    }
+
+    return rules;
+}
+
+RuleSet parse_rules(const Args& args) {
+    return parse_rule_set(args.get("draw").value_or("3"), args.get("passes").value_or("unlimited"), !args.has("no-foundation-return"));
+}
+
+// Like parse_rules, but --draw and --passes can be lists, and we get every combination of them
+std::vector<RuleSet> parse_rule_sweep(const Args& args) {
+    std::vector<std::string> draws = args.get_list("draw");
+    std::vector<std::string> passes = args.get_list("passes");
+    if (draws.empty()) {
+        draws.push_back("3");
+    }
+    if (passes.empty()) {
+        passes.push_back("unlimited");
+    }
+
+    std::vector<RuleSet> sweep;
+    for (const std::string& draw : draws) {
+        for (const std::string& p : passes) {
+            sweep.push_back(parse_rule_set(draw, p, !args.has("no-foundation-return")));
+        }
+    }
+
+    return sweep;
+}
+
+AiOptions parse_ai_options(const Args& args) {
+    AiOptions options;
+    options.beam.width = args.get_int("width", options.beam.width);
+    options.beam.depth = args.get_int("depth", options.beam.depth);
+    options.beam.safeMoves = args.has("safe-moves");
+    if (std::optional<std::string> path = args.get("dennis-params")) {
+        options.dennis = load_dennis_params(*path);
+    }
+    return options;
+}
+
+// A fraction, either as a percentage ("0.5%") or not ("0.005"). nullopt if it isn't a number at
+// all, and throws if it's a number that isn't strictly between 0 and 1 (or 0% and 100%), since
+// "7.5" was almost certainly meant to be 7.5% and we'd rather not guess.
+std::optional<double> parse_fraction(std::string_view option, std::string_view text) {
+    bool percent = text.ends_with('%');
+    std::string_view number = percent ? text.substr(0, text.size() - 1) : text;
+
+    double value;
+    const char* end = number.data() + number.size();
+    auto [ptr, error] = std::from_chars(number.data(), end, value);
+    if (number.empty() || error != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+
+    if (percent && !(value > 0 && value < 100)) {
+        throw std::runtime_error(std::format("Option \"--{}\" should be a percentage between 0% and 100%, not \"{}\"", option, text));
+    } else if (!percent && !(value > 0 && value < 1)) {
+        throw std::runtime_error(std::format(
+            "Option \"--{}\" should be a fraction between 0 and 1, or a percentage with a % after it, not \"{}\"", option, text));
+    }
+
+    return percent ? value / 100 : value;
+}
+
+// --grid, e.g. "4x4" or "6x3"
+std::pair<int, int> parse_grid(const std::string& grid) {
+    size_t x = grid.find('x');
+    if (x == std::string::npos) {
+        throw std::runtime_error(std::format("Option \"--grid\" should look like 4x4, not \"{}\"", grid));
+    }
+
+    int columns = parse_int("grid", grid.substr(0, x));
+    int rows = parse_int("grid", grid.substr(x + 1));
+    if (columns < 1 || rows < 1) {
+        throw std::runtime_error(std::format("Option \"--grid\" needs at least one row and column, not \"{}\"", grid));
+    }
+
+    return { columns, rows };
+}
+
+// The per move budget from --ms-per-move and --nodes-per-move, and --safe-moves
+PlayOptions parse_play_options(const Args& args) {
+    PlayOptions play;
+    play.safeMoves = args.has("safe-moves");
+
+    if (args.has("ms-per-move") || args.has("nodes-per-move")) {
+        SearchBudget budget;
+        if (args.has("ms-per-move")) {
+            budget.seconds = args.get_double("ms-per-move", 0) / 1e3;
+        }
+        if (args.has("nodes-per-move")) {
+            budget.nodes = args.get_int("nodes-per-move", 0);
+        }
+        play.budget = budget;
+    }
+
+    return play;
+}
+
+int run_command(Args& args) {
+    std::vector<std::string>& pos = args.positional;
+
+    if (pos.size() == 2 && pos[0] == "benchmark") {
+        args.expect({ RULE_OPTIONS, AI_OPTIONS, { "games", "threads", "seed", "precision", "compare-against", "save-baseline" } });
+        std::optional<AiFactory> makeAi = ai_factory(pos[1], parse_ai_options(args));
+
+        if (!makeAi) {
+            std::cerr << "Not a valid ai name: \"" << pos[1] << "\"" << std::endl;
             return 1;
         }
 
-        benchmark(3, std::move(ai));
-    } else if (argc == 1) {
-        Game game(3);
+        BenchmarkOptions options;
+        options.rules = parse_rules(args);
+        options.games = args.get_int("games", options.games);
+        options.threads = args.get_int("threads", options.threads);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.play = parse_play_options(args);
+        options.saveBaseline = args.get("save-baseline");
+
+        if (std::optional<std::string> precision = args.get("precision")) {
+            options.precision = parse_fraction("precision", *precision);
+            if (!options.precision) {
+                throw std::runtime_error(std::format("Option \"--precision\" should be a percentage like 0.5%, not \"{}\"", *precision));
+            }
+        }
+
+        // Either a win rate, or a file saved by an earlier run
+        if (std::optional<std::string> baseline = args.get("compare-against")) {
+            if (std::optional<double> rate = parse_fraction("compare-against", *baseline)) {
+                options.baseline = Baseline { .rate = *rate };
+            } else {
+                options.baseline = load_baseline(*baseline);
+            }
+        }
+
+        benchmark(*makeAi, options);
+    } else if (pos.size() >= 3 && pos[0] == "compare") {
+        args.expect({ RULE_OPTIONS, AI_OPTIONS, { "games", "threads", "seed" } });
+        CompareOptions options;
+        options.ruleSets = parse_rule_sweep(args);
+        options.games = args.get_int("games", options.games);
+        options.threads = args.get_int("threads", options.threads);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.play = parse_play_options(args);
+
+        for (size_t i = 1; i < pos.size(); i++) {
+            std::optional<AiFactory> makeAi = ai_factory(pos[i], parse_ai_options(args));
+
+            if (!makeAi) {
+                std::cerr << "Not a valid ai name: \"" << pos[i] << "\"" << std::endl;
+                return 1;
+            }
+
+            options.ais.push_back({ pos[i], *makeAi });
+        }
+
+        compare(options);
+    } else if (pos.size() == 2 && pos[0] == "tune" && pos[1] == "dennis") {
+        args.expect({ RULE_OPTIONS, { "dennis-params", "games", "rounds", "candidates", "threads", "seed", "out" } });
+        TuneOptions options;
+        options.rules = parse_rules(args);
+        options.games = args.get_int("games", options.games);
+        options.rounds = args.get_int("rounds", options.rounds);
+        options.candidates = args.get_int("candidates", options.candidates);
+        options.threads = args.get_int("threads", options.threads);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.output = args.get("out").value_or(options.output);
+
+        tune_dennis(parse_ai_options(args).dennis, options);
+    } else if (pos.size() == 2 && pos[0] == "analyze") {
+        args.expect({ RULE_OPTIONS, AI_OPTIONS, { "threads", "playouts" } });
+        std::optional<AiFactory> makeAi = ai_factory(pos[1], parse_ai_options(args));
+
+        if (!makeAi) {
+            std::cerr << "Not a valid ai name: \"" << pos[1] << "\"" << std::endl;
+            return 1;
+        }
+
+        AnalyzeOptions options;
+        options.rules = parse_rules(args);
+        options.threads = args.get_int("threads", options.threads);
+        options.playouts = args.get_int("playouts", options.playouts);
+        options.play = parse_play_options(args);
+
+        // Otherwise std::cin can't tell how much input is waiting, and analyze answers a line at
+        // a time even when there's plenty to share out
+        std::ios::sync_with_stdio(false);
+        analyze(*makeAi, options, std::cin, std::cout);
+    } else if (pos.size() == 1 && pos[0] == "deal") {
+        args.expect({ RULE_OPTIONS, { "games", "seed" } });
+        unsigned int seed = args.get_int("seed", std::random_device{}());
+        int games = args.get_int("games", 1);
+
+        for (int i = 0; i < games; i++) {
+            Board board(parse_rules(args));
+            board.deal(seed + i);
+            std::println("{}", board_to_text(board));
+        }
+    } else if (pos.size() == 1 && pos[0] == "solve") {
+        args.expect({ RULE_OPTIONS, { "games", "threads", "seed", "nodes", "cache" } });
+        SolveBenchmarkOptions options;
+        options.rules = parse_rules(args);
+        options.games = args.get_int("games", options.games);
+        options.threads = args.get_int("threads", options.threads);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.solver.nodeLimit = args.get_int("nodes", options.solver.nodeLimit);
+        options.cachePath = args.get("cache");
+
+        solve_benchmark(options);
+    } else if (pos.size() == 2 && pos[0] == "watch") {
+        // Like play, the ais think in what's spare of every frame rather than to a budget
+        args.expect({ RULE_OPTIONS, { "width", "depth", "dennis-params", "safe-moves", "seed", "speed", "grid" } });
+        std::optional<AiFactory> makeAi = ai_factory(pos[1], parse_ai_options(args));
+
+        if (!makeAi) {
+            std::cerr << "Not a valid ai name: \"" << pos[1] << "\"" << std::endl;
+            return 1;
+        }
+
+        WatchOptions options;
+        options.rules = parse_rules(args);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.movesPerSecond = args.get_double("speed", options.movesPerSecond);
+        options.safeMoves = args.has("safe-moves");
+        if (std::optional<std::string> grid = args.get("grid")) {
+            std::tie(options.columns, options.rows) = parse_grid(*grid);
+        }
+
+        // The boards are drawn scaled down, which looks awful with nearest neighbour
+        SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
+        Watch watch(options, *makeAi);
+        watch.run();
+    } else if (pos.size() == 2 && pos[0] == "play") {
+        // The ai gets what's spare of every frame to think in, and moves a few times a second, so
+        // the per move budget options don't apply here
+        args.expect({ RULE_OPTIONS, { "width", "depth", "dennis-params", "safe-moves" } });
+        std::optional<AiFactory> makeAi = ai_factory(pos[1], parse_ai_options(args));
+
+        if (!makeAi) {
+            std::cerr << "Not a valid ai name: \"" << pos[1] << "\"" << std::endl;
+            return 1;
+        }
+
+        Game game(parse_rules(args), (*makeAi)(), args.has("safe-moves"));
+        game.run();
+    } else if (pos.size() == 1 && pos[0] == "bench-render") {
+        args.expect({ RULE_OPTIONS, { "frames", "positions", "seed", "positions-file" } });
+        RenderBenchOptions options;
+        options.rules = parse_rules(args);
+        options.frames = args.get_int("frames", options.frames);
+        options.positions = args.get_int("positions", options.positions);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.positionsPath = args.get("positions-file");
+
+        // No window, and no gpu, so the numbers mean the same thing on every machine
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        SDL_SetHint(SDL_HINT_RENDER_DRIVER, "software");
+
+        std::vector<Board> corpus = render_corpus(options);
+        Game game(options.rules);
+        RenderBenchStats stats = game.bench_render(corpus, options.frames);
+        print_render_bench(stats, corpus.size());
+    } else if (pos.size() == 1 && pos[0] == "fuzz") {
+        args.expect({ RULE_OPTIONS, { "replay", "games", "steps", "threads", "seed", "out" } });
+        if (std::optional<std::string> path = args.get("replay")) {
+            return check_fuzz_replay(load_fuzz_replay(*path)) ? 0 : 1;
+        }
+
+        FuzzOptions options;
+        options.ruleSets = parse_rule_sweep(args);
+        options.games = args.get_int("games", options.games);
+        options.steps = args.get_int("steps", options.steps);
+        options.threads = args.get_int("threads", options.threads);
+        options.seed = args.get_int("seed", std::random_device{}());
+        options.failurePath = args.get("out").value_or(options.failurePath);
+
+        return fuzz_rules(options) ? 0 : 1;
+    } else if (pos.size() == 2 && pos[0] == "record") {
+        args.expect({ RULE_OPTIONS });
+        EventTrace trace { .seed = std::random_device{}(), .rules = parse_rules(args), .frames = {} };
+
+        Game game(trace.rules);
+        game.reseed(trace.seed);
+        game.run(&trace);
+
+        save_trace(pos[1], trace);
+    } else if (pos.size() == 2 && pos[0] == "replay") {
+        args.expect({ { "render" } });
+        EventTrace trace = load_trace(pos[1]);
+
+        // We never want a real window here
+        SDL_SetHint(SDL_HINT_VIDEODRIVER, "dummy");
+        Game game(trace.rules);
+        game.reseed(trace.seed);
+        ReplayStats stats = game.replay(trace, args.has("render"));
+
+        std::println("replayed {} frames ({} events) in {}ms ({}us per frame)",
+            stats.frames, stats.events, stats.seconds * 1e3, stats.seconds * 1e6 / std::max(stats.frames, 1));
+        std::println("cards on foundations: {}, solved: {}", stats.foundationCards, stats.solved);
+    } else if (pos.empty()) {
+        args.expect({ RULE_OPTIONS });
+        Game game(parse_rules(args));
         game.run();
     } else {
-        std::println("Usage: bs");
-        std::println("       bs benchmark [AI_NAME]");
-        std::println("\nthe two ais to choose from right now are 'dennis' and 'pippin'.");
+        print_usage();
         return 1;
     }
 
     return 0;
 }
+
+int main(int argc, char **argv) {
+    try {
+        Args args(argc, argv, { "render", "no-foundation-return", "safe-moves" });
+        return run_command(args);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n" << std::endl;
+        print_usage();
+        return 1;
+    }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <utility>
+#include <variant>
+
+enum CardSource {
+    CS_Pile,
+    CS_Playfield,
+    CS_Aces,
+};
+
+struct MoveToStack {
+    CardSource source;
+    std::pair<int, int> fromCoord;
+    int toStackId;
+};
+
+struct MoveToAces {
+    CardSource source;
+    std::pair<int, int> fromCoord;
+    int toAcesId;
+};
+
+struct CyclePile {};
+
+typedef std::variant<MoveToStack, MoveToAces, CyclePile> SolitaireMove;
@@ -0,0 +1,274 @@
+#include "notation.hpp"
+
+#include <charconv>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+const std::string_view VALUE_CHARS = "A23456789TJQK";
+const std::string_view SUIT_CHARS = "hdcs";
+
+std::string card_to_text(const Card& c) {
+    std::string text = c.upturned ? "" : "#";
+    text += VALUE_CHARS[c.value];
+    text += SUIT_CHARS[c.suit];
+    return text;
+}
+
+std::string stack_to_text(const CardStack& stack) {
+    if (stack.empty()) {
+        return "-";
+    }
+
+    std::string text;
+    for (const Card& c : stack) {
+        text += card_to_text(c);
+    }
+    return text;
+}
+
+std::string board_to_text(const Board& board) {
+    std::string text;
+
+    for (const CardStack& stack : board.playfield) {
+        text += stack_to_text(stack) + " ";
+    }
+    for (const CardStack& acesPile : board.aces) {
+        text += stack_to_text(acesPile) + " ";
+    }
+    text += stack_to_text(board.stock) + " ";
+    text += stack_to_text(board.pile) + " ";
+    text += std::to_string(board.redeals);
+
+    return text;
+}
+
+void stack_from_text(std::string_view text, CardStack& stack) {
+    if (text == "-") {
+        return;
+    }
+
+    size_t i = 0;
+    while (i < text.size()) {
+        bool upturned = text[i] != '#';
+        if (!upturned) {
+            i++;
+        }
+
+        size_t value = i < text.size() ? VALUE_CHARS.find(text[i]) : std::string_view::npos;
+        size_t suit = i + 1 < text.size() ? SUIT_CHARS.find(text[i + 1]) : std::string_view::npos;
+
+        if (value == std::string_view::npos || suit == std::string_view::npos) {
+            throw std::runtime_error(std::format("\"{}\" isn't a list of cards", text));
+        }
+
+        stack.push_back(Card(static_cast<Value>(value), static_cast<Suit>(suit), upturned));
+        i += 2;
+    }
+}
+
+// Throws unless the cards are laid out in a way a real game could get to, since the engine takes
+// all of this for granted
+void check_layout(const Board& board) {
+    for (int i = 0; i < 7; i++) {
+        const CardStack& stack = board.playfield.at(i);
+        if (stack.empty()) {
+            continue;
+        }
+
+        // Face down cards at the bottom, then a run of face up cards that could all be moved together
+        size_t firstUp = 0;
+        while (firstUp < stack.size() && !stack[firstUp].upturned) {
+            firstUp++;
+        }
+
+        if (firstUp == stack.size()) {
+            throw std::runtime_error(std::format("The top card of playfield stack {} has to be face up", i));
+        }
+
+        for (size_t j = firstUp + 1; j < stack.size(); j++) {
+            if (!stack[j].upturned) {
+                throw std::runtime_error(std::format("Playfield stack {} has a face down {} above a face up card", i, card_to_text(stack[j])));
+            }
+            if (!stack[j].can_be_placed_on(stack[j - 1])) {
+                throw std::runtime_error(std::format("{} can't be on {} in playfield stack {}", card_to_text(stack[j]), card_to_text(stack[j - 1]), i));
+            }
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        const CardStack& acesPile = board.aces.at(i);
+
+        for (size_t j = 0; j < acesPile.size(); j++) {
+            if (!acesPile[j].upturned) {
+                throw std::runtime_error(std::format("Aces pile {} has a face down {}", i, card_to_text(acesPile[j])));
+            }
+
+            if (j == 0 && acesPile[j].value != Ace) {
+                throw std::runtime_error(std::format("Aces pile {} has to start with an ace, not {}", i, card_to_text(acesPile[j])));
+            }
+            if (j > 0 && !acesPile[j].follows_on_aces(acesPile[j - 1])) {
+                throw std::runtime_error(std::format("{} can't go on {} in aces pile {}", card_to_text(acesPile[j]), card_to_text(acesPile[j - 1]), i));
+            }
+        }
+    }
+
+    // The stock and pile don't have face down cards, since nothing ever turns them over
+    for (const CardStack* stack : { &board.stock, &board.pile }) {
+        for (const Card& c : *stack) {
+            if (!c.upturned) {
+                throw std::runtime_error(std::format("The stock and pile are written face up, not as {}", card_to_text(c)));
+            }
+        }
+    }
+}
+
+Board board_from_text(std::string_view text, RuleSet rules) {
+    std::istringstream in { std::string(text) };
+    std::vector<std::string> fields;
+    for (std::string field; in >> field;) {
+        fields.push_back(field);
+    }
+
+    if (fields.size() != 14) {
+        throw std::runtime_error(std::format("A board needs 14 fields, not {}", fields.size()));
+    }
+
+    Board board(rules);
+    for (int i = 0; i < 7; i++) {
+        stack_from_text(fields[i], board.playfield.at(i));
+    }
+    for (int i = 0; i < 4; i++) {
+        stack_from_text(fields[7 + i], board.aces.at(i));
+    }
+    stack_from_text(fields[11], board.stock);
+    stack_from_text(fields[12], board.pile);
+
+    const std::string& redeals = fields[13];
+    auto [end, error] = std::from_chars(redeals.data(), redeals.data() + redeals.size(), board.redeals);
+    if (error != std::errc() || end != redeals.data() + redeals.size() || board.redeals < 0) {
+        throw std::runtime_error(std::format("\"{}\" isn't a number of redeals", redeals));
+    }
+    // With n passes through the stock, it can only have been turned back over n - 1 times
+    if (rules.passes != 0 && board.redeals >= rules.passes) {
+        throw std::runtime_error(std::format("There can't have been {} redeals with {}", board.redeals, describe(rules)));
+    }
+
+    // Every card should be there exactly once
+    uint64_t seen = 0;
+    int count = 0;
+    auto check = [&](const CardStack& stack) {
+        for (const Card& c : stack) {
+            seen |= uint64_t(1) << c.index();
+            count++;
+        }
+    };
+
+    for (const CardStack& stack : board.playfield) {
+        check(stack);
+    }
+    for (const CardStack& acesPile : board.aces) {
+        check(acesPile);
+    }
+    check(board.stock);
+    check(board.pile);
+
+    if (count != 52 || seen != (uint64_t(1) << 52) - 1) {
+        throw std::runtime_error("A board needs every card in the deck exactly once");
+    }
+
+    check_layout(board);
+    return board;
+}
+
+std::string source_to_text(CardSource source, std::pair<int, int> coord) {
+    switch (source) {
+        case CS_Pile:
+            return "pile";
+        case CS_Playfield:
+            return std::format("s{}:{}", coord.first, coord.second);
+        case CS_Aces:
+            return std::format("a{}", coord.first);
+    }
+    return "?";
+}
+
+std::string move_to_text(const SolitaireMove& move) {
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        return std::format("{}>s{}", source_to_text(m->source, m->fromCoord), m->toStackId);
+    } else if (const MoveToAces* m = std::get_if<MoveToAces>(&move)) {
+        return std::format("{}>a{}", source_to_text(m->source, m->fromCoord), m->toAcesId);
+    } else {
+        return "cycle";
+    }
+}
+
+// A number from the start of the text, and what's left after it
+int number_from_text(std::string_view& text, std::string_view move) {
+    size_t digits = 0;
+    while (digits < text.size() && text[digits] >= '0' && text[digits] <= '9') {
+        digits++;
+    }
+
+    if (digits == 0 || digits > 2) {
+        throw std::runtime_error(std::format("\"{}\" isn't a move", move));
+    }
+
+    int n = std::stoi(std::string(text.substr(0, digits)));
+    text.remove_prefix(digits);
+    return n;
+}
+
+SolitaireMove move_from_text(std::string_view text) {
+    if (text == "cycle") {
+        return CyclePile {};
+    }
+
+    size_t arrow = text.find('>');
+    if (arrow == std::string_view::npos) {
+        throw std::runtime_error(std::format("\"{}\" isn't a move", text));
+    }
+
+    std::string_view from = text.substr(0, arrow);
+    std::string_view to = text.substr(arrow + 1);
+
+    CardSource source;
+    std::pair<int, int> coord = { 0, 0 };
+    if (from == "pile") {
+        source = CS_Pile;
+        from.remove_prefix(4);
+    } else if (from.starts_with('s')) {
+        source = CS_Playfield;
+        from.remove_prefix(1);
+        coord.first = number_from_text(from, text);
+        if (!from.starts_with(':')) {
+            throw std::runtime_error(std::format("\"{}\" isn't a move", text));
+        }
+        from.remove_prefix(1);
+        coord.second = number_from_text(from, text);
+    } else if (from.starts_with('a')) {
+        source = CS_Aces;
+        from.remove_prefix(1);
+        coord.first = number_from_text(from, text);
+    } else {
+        throw std::runtime_error(std::format("\"{}\" isn't a move", text));
+    }
+
+    if (!from.empty() || to.size() < 2 || (to[0] != 's' && to[0] != 'a')) {
+        throw std::runtime_error(std::format("\"{}\" isn't a move", text));
+    }
+
+    bool toStack = to[0] == 's';
+    to.remove_prefix(1);
+    int target = number_from_text(to, text);
+    if (!to.empty() || coord.first >= (source == CS_Aces ? 4 : 7) || target >= (toStack ? 7 : 4)) {
+        throw std::runtime_error(std::format("\"{}\" isn't a move", text));
+    }
+
+    if (toStack) {
+        return MoveToStack { .source = source, .fromCoord = coord, .toStackId = target };
+    } else {
+        return MoveToAces { .source = source, .fromCoord = coord, .toAcesId = target };
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include "board.hpp"
+#include "moves.hpp"
+
+// Boards and moves as short lines of text, for feeding positions in and out of `bs analyze`.
+//
+// A card is its value (A23456789TJQK) then its suit (hdcs), e.g. "Th" for the ten of hearts.
+// Face down cards get a '#' in front, e.g. "#Th".
+//
+// A board is 14 fields separated by spaces:
+//
+//     the 7 playfield stacks, the 4 aces piles, the stock, the pile, and the number of redeals
+//
+// Each stack is its cards from the bottom up with nothing between them, or "-" if it's empty.
+// The top of the stock is the card that gets dealt next. For example, a fresh deal starts
+//
+//     9c #5dKs #3d#2hQh ...
+std::string card_to_text(const Card& c);
+std::string board_to_text(const Board& board);
+// Throws if the text isn't a board, or isn't one a game under these rules could get to: every card
+// exactly once, the aces piles in order, face down cards only at the bottom of playfield stacks
+// under a run, and no more redeals than the rules allow
+Board board_from_text(std::string_view text, RuleSet rules);
+
+// Moves are "cycle", or where the card comes from and goes to with a '>' between, e.g. "pile>s3",
+// "s2:4>a0" or "a1>s6". s2:4 is the 5th card up from the bottom of playfield stack 2 (counting
+// from 0), a0 is the first aces pile.
+std::string move_to_text(const SolitaireMove& move);
+// Throws if the text isn't a move. Doesn't check whether the move is legal anywhere.
+SolitaireMove move_from_text(std::string_view text);
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// How many worker threads to use when asked for `requested` (0 means one per hardware thread)
+inline int worker_count(int requested) {
+    return requested > 0 ? requested : std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Runs f(worker, index) for every index in [0, count) spread over `workers` threads, and waits for
+// them all to finish. Indices are handed out one at a time, so uneven jobs balance out.
+// f is called from several threads at once, so anything it shares needs to be thread safe.
+template <typename F>
+void parallel_for(int count, int workers, F&& f) {
+    std::atomic<int> next = 0;
+    std::vector<std::jthread> threads;
+
+    for (int w = 0; w < workers; w++) {
+        threads.emplace_back([&, w] {
+            for (int i = next++; i < count; i = next++) {
+                f(w, i);
+            }
+        });
+    }
+}
@@ -0,0 +1,100 @@
+#include "render_bench.hpp"
+#include "notation.hpp"
+#include "ai/dennis.hpp"
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <numeric>
+#include <print>
+#include <stdexcept>
+
+// The most moves dennis gets to play into a made up position
+const int CORPUS_MAX_MOVES = 120;
+
+std::vector<Board> render_corpus(const RenderBenchOptions& options) {
+    std::vector<Board> positions;
+
+    if (options.positionsPath) {
+        std::ifstream in(*options.positionsPath);
+        if (!in) {
+            throw std::runtime_error(std::format("Couldn't open positions file \"{}\"", *options.positionsPath));
+        }
+
+        std::string line;
+        while (std::getline(in, line)) {
+            if (!line.empty()) {
+                positions.push_back(board_from_text(line, options.rules));
+            }
+        }
+
+        if (positions.empty()) {
+            throw std::runtime_error(std::format("No positions in \"{}\"", *options.positionsPath));
+        }
+
+        return positions;
+    }
+
+    for (int i = 0; i < options.positions; i++) {
+        Board board(options.rules);
+        board.deal(options.seed + i);
+
+        // Spread the positions evenly from fresh deals to as far as dennis gets
+        int moves = i * CORPUS_MAX_MOVES / std::max(options.positions, 1);
+        Dennis dennis(DennisParams {}, options.seed + i);
+
+        for (int m = 0; m < moves && !board.is_solved(); m++) {
+            std::optional<SolitaireMove> move = dennis.nextMove(board);
+            if (!move) {
+                break;
+            }
+            board.apply_move(*move);
+        }
+
+        positions.push_back(board);
+    }
+
+    return positions;
+}
+
+// The value that fraction p of the (sorted) values are at or below
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0;
+    }
+
+    size_t i = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[i];
+}
+
+void print_frame_times(std::string_view label, std::vector<double> seconds) {
+    if (seconds.empty()) {
+        return;
+    }
+
+    std::sort(seconds.begin(), seconds.end());
+    double mean = std::accumulate(seconds.begin(), seconds.end(), 0.0) / seconds.size();
+
+    std::println("  {:<14} {:>6} frames, mean {:>8.1f}us, p50 {:>8.1f}us, p90 {:>8.1f}us, p99 {:>8.1f}us, max {:>8.1f}us",
+        label, seconds.size(), mean * 1e6, percentile(seconds, 0.5) * 1e6, percentile(seconds, 0.9) * 1e6,
+        percentile(seconds, 0.99) * 1e6, seconds.back() * 1e6);
+}
+
+void print_render_bench(const RenderBenchStats& stats, size_t positions) {
+    std::vector<double> redrawn;
+    std::vector<double> cached;
+    for (size_t i = 0; i < stats.frameSeconds.size(); i++) {
+        (stats.frameRedrawn[i] ? redrawn : cached).push_back(stats.frameSeconds[i]);
+    }
+
+    double totalSeconds = std::accumulate(stats.frameSeconds.begin(), stats.frameSeconds.end(), 0.0);
+    uint64_t totalCalls = std::accumulate(stats.frameDrawCalls.begin(), stats.frameDrawCalls.end(), uint64_t { 0 });
+    int maxCalls = stats.frameDrawCalls.empty() ? 0 : *std::max_element(stats.frameDrawCalls.begin(), stats.frameDrawCalls.end());
+    size_t frames = std::max<size_t>(stats.frameSeconds.size(), 1);
+
+    std::println("rendered {} frames of {} positions ({} dragging cards) in {:.2f}s with the {} renderer",
+        stats.frameSeconds.size(), positions, stats.dragFrames, totalSeconds, stats.driver);
+    print_frame_times("all", stats.frameSeconds);
+    print_frame_times("board redrawn", redrawn);
+    print_frame_times("board cached", cached);
+    std::println("{} draw calls ({:.1f} per frame, at most {})", totalCalls, static_cast<double>(totalCalls) / frames, maxCalls);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "board.hpp"
+#include "rules.hpp"
+
+// `bs bench-render`: times Game::render on its own, with no window and no gpu, so rendering
+// changes can be measured on any machine.
+
+struct RenderBenchOptions {
+    RuleSet rules;
+    // How many positions to make up when there's no file of them
+    int positions = 64;
+    // Frames to render in total, split evenly between the positions
+    int frames = 5000;
+    unsigned int seed = 0;
+    // Boards to render, one per line in the notation from notation.hpp (e.g. from `bs deal`)
+    std::optional<std::string> positionsPath;
+};
+
+struct RenderBenchStats {
+    // How long each frame took, and how many draw calls it made
+    std::vector<double> frameSeconds;
+    std::vector<int> frameDrawCalls;
+    // Which frames had to redraw the board layer, rather than just blitting it
+    std::vector<char> frameRedrawn;
+    // How many frames had cards being dragged around
+    int dragFrames = 0;
+    std::string driver;
+};
+
+// The positions to render. Either read from options.positionsPath, or made by dealing games from
+// options.seed and letting dennis play a different number of moves into each, so there's a mix
+// of early and late game boards.
+std::vector<Board> render_corpus(const RenderBenchOptions& options);
+
+void print_render_bench(const RenderBenchStats& stats, size_t positions);
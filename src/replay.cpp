@@ -0,0 +1,174 @@
+#include "replay.hpp"
+
+#include <SDL.h>
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <stdexcept>
+
+// File layout (all little endian, since that's all we run on):
+//
+// "BSTR" | version: u8 | seed: u32 | draw: u8 | passes: u8 | foundation return: u8 | frame count: u32
+// then for every frame:
+//   microseconds since the last frame: u32 | event count: u16 | events...
+// where every event starts with a one byte kind and then:
+//   EK_Quit:       nothing
+//   EK_Key:        sym: i32
+//   EK_Motion:     x: i16, y: i16
+//   EK_ButtonDown,
+//   EK_ButtonUp:   button: u8, x: i16, y: i16
+
+const char TRACE_MAGIC[4] = { 'B', 'S', 'T', 'R' };
+const Uint8 TRACE_VERSION = 4;
+
+enum EventKind : Uint8 {
+    EK_Quit,
+    EK_Key,
+    EK_Motion,
+    EK_ButtonDown,
+    EK_ButtonUp,
+};
+
+template <typename T>
+void write_value(std::ofstream& out, T value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T read_value(std::ifstream& in) {
+    T value;
+    if (!in.read(reinterpret_cast<char*>(&value), sizeof(T))) {
+        throw std::runtime_error("Event trace ended unexpectedly");
+    }
+    return value;
+}
+
+bool is_recordable(const SDL_Event& e) {
+    return e.type == SDL_QUIT
+        || e.type == SDL_KEYDOWN
+        || e.type == SDL_MOUSEMOTION
+        || e.type == SDL_MOUSEBUTTONDOWN
+        || e.type == SDL_MOUSEBUTTONUP;
+}
+
+void write_event(std::ofstream& out, const SDL_Event& e) {
+    switch (e.type) {
+        case SDL_QUIT:
+            write_value<Uint8>(out, EK_Quit);
+            break;
+        case SDL_KEYDOWN:
+            write_value<Uint8>(out, EK_Key);
+            write_value<Sint32>(out, e.key.keysym.sym);
+            break;
+        case SDL_MOUSEMOTION:
+            write_value<Uint8>(out, EK_Motion);
+            write_value<int16_t>(out, e.motion.x);
+            write_value<int16_t>(out, e.motion.y);
+            break;
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            write_value<Uint8>(out, e.type == SDL_MOUSEBUTTONDOWN ? EK_ButtonDown : EK_ButtonUp);
+            write_value<Uint8>(out, e.button.button);
+            write_value<int16_t>(out, e.button.x);
+            write_value<int16_t>(out, e.button.y);
+            break;
+        default:
+            throw std::runtime_error(std::format("Tried to record an unsupported event type {}", e.type));
+    }
+}
+
+SDL_Event read_event(std::ifstream& in) {
+    SDL_Event e {};
+    Uint8 kind = read_value<Uint8>(in);
+
+    switch (kind) {
+        case EK_Quit:
+            e.type = SDL_QUIT;
+            break;
+        case EK_Key:
+            e.type = SDL_KEYDOWN;
+            e.key.keysym.sym = read_value<Sint32>(in);
+            break;
+        case EK_Motion:
+            e.type = SDL_MOUSEMOTION;
+            e.motion.x = read_value<int16_t>(in);
+            e.motion.y = read_value<int16_t>(in);
+            break;
+        case EK_ButtonDown:
+        case EK_ButtonUp:
+            e.type = kind == EK_ButtonDown ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+            e.button.state = kind == EK_ButtonDown ? SDL_PRESSED : SDL_RELEASED;
+            e.button.button = read_value<Uint8>(in);
+            e.button.x = read_value<int16_t>(in);
+            e.button.y = read_value<int16_t>(in);
+            break;
+        default:
+            throw std::runtime_error(std::format("Unknown event kind {} in event trace", kind));
+    }
+
+    return e;
+}
+
+void save_trace(const std::string& path, const EventTrace& trace) {
+    std::ofstream out(path, std::ios::binary);
+
+    if (!out) {
+        throw std::runtime_error(std::format("Couldn't open \"{}\" for writing", path));
+    }
+
+    out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    write_value<Uint8>(out, TRACE_VERSION);
+    write_value<Uint32>(out, trace.seed);
+    write_value<Uint8>(out, trace.rules.draw);
+    write_value<Uint8>(out, trace.rules.passes);
+    write_value<Uint8>(out, trace.rules.foundationReturn);
+    write_value<Uint32>(out, trace.frames.size());
+
+    for (const RecordedFrame& frame : trace.frames) {
+        write_value<Uint32>(out, frame.delta);
+        write_value<Uint16>(out, frame.events.size());
+
+        for (const SDL_Event& e : frame.events) {
+            write_event(out, e);
+        }
+    }
+}
+
+EventTrace load_trace(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+
+    if (!in) {
+        throw std::runtime_error(std::format("Couldn't open event trace \"{}\"", path));
+    }
+
+    char magic[4];
+    if (!in.read(magic, sizeof(magic)) || !std::equal(magic, magic + 4, TRACE_MAGIC)) {
+        throw std::runtime_error(std::format("\"{}\" is not an event trace", path));
+    }
+
+    if (Uint8 version = read_value<Uint8>(in); version != TRACE_VERSION) {
+        throw std::runtime_error(std::format("Unsupported event trace version {}", version));
+    }
+
+    EventTrace trace;
+    trace.seed = read_value<Uint32>(in);
+    trace.rules.draw = read_value<Uint8>(in);
+    trace.rules.passes = read_value<Uint8>(in);
+    trace.rules.foundationReturn = read_value<Uint8>(in);
+
+    Uint32 frameCount = read_value<Uint32>(in);
+    trace.frames.resize(frameCount);
+
+    for (RecordedFrame& frame : trace.frames) {
+        frame.delta = read_value<Uint32>(in);
+        Uint16 eventCount = read_value<Uint16>(in);
+
+        frame.events.reserve(eventCount);
+        for (int i = 0; i < eventCount; i++) {
+            frame.events.push_back(read_event(in));
+        }
+    }
+
+    return trace;
+}
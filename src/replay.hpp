@@ -0,0 +1,39 @@
+#pragma once
+
+#include <SDL.h>
+#include <string>
+#include <vector>
+#include "rules.hpp"
+
+// A recording of the input events of one interactive session, so it can be played back later
+// without anyone at the mouse (see Game::replay).
+
+struct RecordedFrame {
+    // Microseconds since the previous recorded frame (or the start of the recording), so a
+    // recording can go on for as long as anyone likes. Capped at UINT32_MAX, a bit over an hour.
+    Uint32 delta;
+    std::vector<SDL_Event> events;
+};
+
+struct EventTrace {
+    // Seed for the game's shuffling rng, so the replay gets the same deals
+    unsigned int seed;
+    RuleSet rules;
+    // Only frames that had events in them are recorded. Frames without input don't change
+    // anything in human mode (and only human games get recorded), so there's no need to store them
+    std::vector<RecordedFrame> frames;
+};
+
+struct ReplayStats {
+    int frames;
+    int events;
+    double seconds;
+    int foundationCards;
+    bool solved;
+};
+
+// Whether the event is one that gets recorded (and so one that the game actually uses)
+bool is_recordable(const SDL_Event& e);
+
+void save_trace(const std::string& path, const EventTrace& trace);
+EventTrace load_trace(const std::string& path);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <format>
+#include <stdexcept>
+#include <string>
+
+// The variations of the rules that we support.
+//
+// The engine and the move generator are templates over one of these, so each variant gets its
+// own copy of the hot code with the rule checks compiled away.
+template <int Draw, int Passes, bool FoundationReturn>
+struct Rules {
+    // How many cards get dealt from the stock at a time
+    static constexpr int draw = Draw;
+    // How many times you can go through the stock, or 0 for as many as you like
+    // (1 is Vegas rules)
+    static constexpr int passes = Passes;
+    // Whether cards can be moved back down from the aces
+    static constexpr bool foundationReturn = FoundationReturn;
+};
+
+// The same thing, but picked at runtime (e.g. from the command line)
+struct RuleSet {
+    int draw = 3;
+    int passes = 0;
+    bool foundationReturn = true;
+
+    bool operator==(const RuleSet&) const = default;
+};
+
+// Whether with_rules can handle this rule set
+inline bool is_supported(const RuleSet& rules) {
+    return (rules.draw == 1 || rules.draw == 3) && (rules.passes == 0 || rules.passes == 1 || rules.passes == 3);
+}
+
+inline std::string describe(const RuleSet& rules) {
+    std::string passes = rules.passes == 0 ? "unlimited passes" : std::format("{} pass{}", rules.passes, rules.passes == 1 ? "" : "es");
+    return std::format("draw {}, {}{}", rules.draw, passes, rules.foundationReturn ? "" : ", no moves from the aces");
+}
+
+namespace detail {
+
+template <int Draw, int Passes, typename F>
+decltype(auto) with_foundation_rule(const RuleSet& rules, F&& f) {
+    if (rules.foundationReturn) {
+        return f.template operator()<Rules<Draw, Passes, true>>();
+    } else {
+        return f.template operator()<Rules<Draw, Passes, false>>();
+    }
+}
+
+template <int Draw, typename F>
+decltype(auto) with_passes(const RuleSet& rules, F&& f) {
+    switch (rules.passes) {
+        case 0:
+            return with_foundation_rule<Draw, 0>(rules, f);
+        case 1:
+            return with_foundation_rule<Draw, 1>(rules, f);
+        case 3:
+            return with_foundation_rule<Draw, 3>(rules, f);
+        default:
+            throw std::runtime_error(std::format("Unsupported number of passes: {}", rules.passes));
+    }
+}
+
+}
+
+// Calls f.template operator()<R>() where R is the Rules type matching the rule set. This is how
+// we get from runtime rules to the specialised code, e.g.
+//
+//     with_rules(board.rules, [&]<typename R>() { board.apply_move<R>(move); });
+//
+// Try to do this once around a loop rather than for every move.
+template <typename F>
+decltype(auto) with_rules(const RuleSet& rules, F&& f) {
+    switch (rules.draw) {
+        case 1:
+            return detail::with_passes<1>(rules, f);
+        case 3:
+            return detail::with_passes<3>(rules, f);
+        default:
+            throw std::runtime_error(std::format("Unsupported draw count: {}", rules.draw));
+    }
+}
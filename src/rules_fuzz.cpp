@@ -0,0 +1,566 @@
+#include "rules_fuzz.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <print>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <variant>
+#include "board.hpp"
+#include "notation.hpp"
+#include "parallel.hpp"
+#include "rules_reference.hpp"
+#include "trace.hpp"
+#include "utils.hpp"
+#include "ai/benchmark.hpp"
+#include "ai/utils.hpp"
+
+// Out of every 100 steps of a random game, about how many are undos and how many are
+// apply_safe_moves. The rest are random legal moves.
+const int UNDO_PERCENT = 5;
+const int SAFE_MOVES_PERCENT = 5;
+
+// Where a game stopped agreeing
+struct FuzzFailure {
+    // How many steps had been played, including the one that went wrong. 0 if the starting
+    // position was already different.
+    int steps;
+    std::string what;
+};
+
+// A number for each move, so lists of them can be sorted and compared quickly. Moves that only
+// differ in parts of the coord that nothing looks at (all of it for the pile, the second half for
+// the aces) get the same number.
+int move_key(const SolitaireMove& move) {
+    auto source_key = [](CardSource source, std::pair<int, int> coord) {
+        switch (source) {
+            case CS_Pile:
+                return 0;
+            case CS_Aces:
+                return 1 + coord.first;
+            default:
+                return 5 + coord.first * 32 + coord.second;
+        }
+    };
+
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        return 1 + 2 * (source_key(m->source, m->fromCoord) * 8 + m->toStackId);
+    } else if (const MoveToAces* m = std::get_if<MoveToAces>(&move)) {
+        return 2 + 2 * (source_key(m->source, m->fromCoord) * 8 + m->toAcesId);
+    } else {
+        return 0;
+    }
+}
+
+// Whether the two hold the same cards in the same order, face up and down the same way
+template <typename A, typename B>
+bool same_cards(const A& a, const B& b) {
+    return std::equal(a.begin(), a.end(), b.begin(), b.end(), [](const Card& x, const Card& y) {
+        return x.value == y.value && x.suit == y.suit && x.upturned == y.upturned;
+    });
+}
+
+bool same_position(const Board& engine, const ReferenceBoard& reference) {
+    for (int i = 0; i < 7; i++) {
+        if (!same_cards(engine.playfield[i], reference.playfield[i])) {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (!same_cards(engine.aces[i], reference.aces[i])) {
+            return false;
+        }
+    }
+
+    return same_cards(engine.stock, reference.stock)
+        && same_cards(engine.pile, reference.pile)
+        && engine.redeals == reference.redeals;
+}
+
+// The moves in `moves` that aren't in `others`, as text
+template <typename A, typename B>
+std::string moves_missing_from(const A& moves, const B& others) {
+    std::vector<int> otherKeys;
+    for (const SolitaireMove& m : others) {
+        otherKeys.push_back(move_key(m));
+    }
+
+    std::string text;
+    for (const SolitaireMove& m : moves) {
+        auto found = std::find(otherKeys.begin(), otherKeys.end(), move_key(m));
+        if (found == otherKeys.end()) {
+            text += " " + move_to_text(m);
+        } else {
+            // So a move listed twice shows up as missing the second time
+            otherKeys.erase(found);
+        }
+    }
+
+    return text.empty() ? " none" : text;
+}
+
+// The engine and the reference side by side, in the same position as long as nothing's wrong
+template <typename R>
+struct DiffRun {
+    DiffRun(const Board& start, std::pmr::memory_resource* memory) :
+        engine(start, memory), reference(start), memory(memory)
+    {
+        engineHistory.reserve(256);
+        referenceHistory.reserve(256);
+    }
+
+    Board engine;
+    ReferenceBoard reference;
+    std::pmr::memory_resource* memory;
+
+    // For each step so far, what the engine needs to take it back, and the reference before it.
+    // A step that was apply_safe_moves has no record, and takes the last of safeSteps instead.
+    std::vector<std::optional<MoveRecord>> engineHistory;
+    std::vector<SafeMoveStep> safeSteps;
+    std::vector<ReferenceBoard> referenceHistory;
+
+    // The reference's moves from here, as of the last compare()
+    std::vector<SolitaireMove> legal;
+
+    // Checks everything about the current position. Returns what's different, if anything.
+    std::optional<std::string> compare();
+    // Makes the step on both. Throws if the reference says it can't be made here. Returns what
+    // went wrong on the engine's side, if anything.
+    std::optional<std::string> play(const FuzzAction& action);
+};
+
+template <typename R>
+std::optional<std::string> DiffRun<R>::compare() {
+    if (!same_position(engine, reference)) {
+        return std::format("the boards are different\n  engine:    {}\n  reference: {}",
+            board_to_text(engine), board_to_text(reference.to_board()));
+    }
+
+    if (engine.is_solved() != reference.is_solved()) {
+        return std::format("is_solved says {} but the reference says {} in {}",
+            engine.is_solved(), reference.is_solved(), board_to_text(engine));
+    }
+
+    legal = reference.legal_moves();
+    std::vector<SolitaireMove> listed;
+    std::copy_if(legal.begin(), legal.end(), std::back_inserter(listed), [&](const SolitaireMove& m) { return reference.is_listed(m); });
+
+    try {
+        MoveList moves = possible_moves<R>(engine, memory);
+
+        // possible_moves promises the cycle comes first
+        for (size_t i = 1; i < moves.size(); i++) {
+            if (std::holds_alternative<CyclePile>(moves[i])) {
+                return std::format("possible_moves put the cycle at {} rather than first in {}", i, board_to_text(engine));
+            }
+        }
+
+        std::vector<int> engineKeys, referenceKeys;
+        for (const SolitaireMove& m : moves) {
+            engineKeys.push_back(move_key(m));
+        }
+        for (const SolitaireMove& m : listed) {
+            referenceKeys.push_back(move_key(m));
+        }
+        std::sort(engineKeys.begin(), engineKeys.end());
+        std::sort(referenceKeys.begin(), referenceKeys.end());
+
+        if (engineKeys != referenceKeys) {
+            return std::format("the legal moves are different in {}\n  only possible_moves has:{}\n  only the reference has:{}",
+                board_to_text(engine), moves_missing_from(moves, listed), moves_missing_from(listed, moves));
+        }
+    } catch (const std::exception& e) {
+        return std::format("possible_moves threw in {}: {}", board_to_text(engine), e.what());
+    }
+
+    return std::nullopt;
+}
+
+template <typename R>
+std::optional<std::string> DiffRun<R>::play(const FuzzAction& action) {
+    switch (action.kind) {
+        case FA_Move: {
+            int key = move_key(action.move);
+            bool isLegal = std::any_of(legal.begin(), legal.end(), [&](const SolitaireMove& m) { return move_key(m) == key; });
+            if (!isLegal) {
+                throw std::runtime_error(std::format("{} isn't a legal move in {}", move_to_text(action.move), board_to_text(reference.to_board())));
+            }
+
+            referenceHistory.push_back(reference);
+            reference.apply(action.move);
+
+            try {
+                engineHistory.push_back(engine.apply_move<R>(action.move));
+            } catch (const std::exception& e) {
+                return std::format("apply_move threw on {}: {}", move_to_text(action.move), e.what());
+            }
+            return std::nullopt;
+        }
+
+        case FA_Undo: {
+            if (referenceHistory.empty()) {
+                throw std::runtime_error("There's nothing to undo");
+            }
+
+            reference = std::move(referenceHistory.back());
+            referenceHistory.pop_back();
+
+            try {
+                if (engineHistory.back()) {
+                    engine.undo_move(*engineHistory.back());
+                } else {
+                    engine.undo_safe_moves(safeSteps.back());
+                    safeSteps.pop_back();
+                }
+            } catch (const std::exception& e) {
+                return std::format("undoing threw: {}", e.what());
+            }
+
+            engineHistory.pop_back();
+            return std::nullopt;
+        }
+
+        case FA_SafeMoves: {
+            referenceHistory.push_back(reference);
+
+            try {
+                safeSteps.push_back(engine.apply_safe_moves<R>());
+            } catch (const std::exception& e) {
+                return std::format("apply_safe_moves threw: {}", e.what());
+            }
+            engineHistory.push_back(std::nullopt);
+            const SafeMoveStep& step = safeSteps.back();
+
+            // Every card it put up has to be legal to put up, and safe, at the time it went up
+            for (int i = 0; i < step.count; i++) {
+                const MoveToAces& m = step.moves[i].move;
+                std::vector<SolitaireMove> moves = reference.legal_moves();
+                bool isLegal = std::any_of(moves.begin(), moves.end(), [&](const SolitaireMove& l) { return move_key(l) == move_key(m); });
+                if (!isLegal) {
+                    return std::format("apply_safe_moves made {}, which isn't legal in {}", move_to_text(m), board_to_text(reference.to_board()));
+                }
+
+                const Card& c = m.source == CS_Pile ? reference.pile.back() : reference.playfield[m.fromCoord.first].back();
+                if (!reference.is_safe_for_aces(c)) {
+                    return std::format("apply_safe_moves put up {}, which isn't safe in {}", card_to_text(c), board_to_text(reference.to_board()));
+                }
+
+                reference.apply(m);
+            }
+
+            if (std::vector<Card> left = reference.safe_cards(); !left.empty()) {
+                return std::format("apply_safe_moves stopped with {} still safe to put up", card_to_text(left[0]));
+            }
+            return std::nullopt;
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Plays the step on both and compares the position after it
+template <typename R>
+std::optional<std::string> fuzz_step(DiffRun<R>& run, const FuzzAction& action) {
+    if (std::optional<std::string> what = run.play(action)) {
+        return what;
+    }
+    return run.compare();
+}
+
+// A random step to play next, or nothing if there's nothing left to do
+template <typename R>
+std::optional<FuzzAction> random_action(const DiffRun<R>& run, std::mt19937& rand) {
+    int roll = rand() % 100;
+    bool canUndo = !run.referenceHistory.empty();
+
+    if (roll < UNDO_PERCENT && canUndo) {
+        return FuzzAction { FA_Undo, CyclePile {} };
+    } else if (roll < UNDO_PERCENT + SAFE_MOVES_PERCENT) {
+        return FuzzAction { FA_SafeMoves, CyclePile {} };
+    } else if (!run.legal.empty()) {
+        return FuzzAction { FA_Move, run.legal[rand() % run.legal.size()] };
+    } else if (canUndo) {
+        return FuzzAction { FA_Undo, CyclePile {} };
+    }
+
+    return std::nullopt;
+}
+
+// Plays up to `steps` random steps from the start, and leaves them in `actions`
+template <typename R>
+std::optional<FuzzFailure> fuzz_game(const Board& start, std::mt19937& rand, int steps, std::vector<FuzzAction>& actions, std::pmr::memory_resource* memory) {
+    DiffRun<R> run(start, memory);
+    actions.clear();
+
+    if (std::optional<std::string> what = run.compare()) {
+        return FuzzFailure { 0, *what };
+    }
+
+    while ((int)actions.size() < steps) {
+        std::optional<FuzzAction> action = random_action(run, rand);
+        if (!action) {
+            break;
+        }
+
+        actions.push_back(*action);
+        if (std::optional<std::string> what = fuzz_step(run, *action)) {
+            return FuzzFailure { (int)actions.size(), *what };
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Plays the steps from the start. Throws if one of them can't be made.
+template <typename R>
+std::optional<FuzzFailure> replay_actions(const Board& start, const std::vector<FuzzAction>& actions) {
+    DiffRun<R> run(start, std::pmr::get_default_resource());
+
+    if (std::optional<std::string> what = run.compare()) {
+        return FuzzFailure { 0, *what };
+    }
+
+    for (size_t i = 0; i < actions.size(); i++) {
+        if (std::optional<std::string> what = fuzz_step(run, actions[i])) {
+            return FuzzFailure { (int)i + 1, *what };
+        }
+    }
+
+    return std::nullopt;
+}
+
+// Cuts steps out of the game for as long as what's left still disagrees somewhere, first in big
+// chunks and then one at a time, until no single step can go. What's left doesn't have to
+// disagree in the same way as the original, any disagreement will do.
+template <typename R>
+FuzzFailure shrink(const Board& start, std::vector<FuzzAction>& actions, FuzzFailure failure) {
+    TRACE_SCOPE("shrink");
+
+    // Anything after the step that went wrong doesn't matter
+    actions.resize(failure.steps);
+
+    size_t chunk = std::max<size_t>(actions.size() / 2, 1);
+    while (!actions.empty()) {
+        bool removed = false;
+
+        for (size_t i = 0; i < actions.size();) {
+            std::vector<FuzzAction> candidate = actions;
+            candidate.erase(candidate.begin() + i, candidate.begin() + std::min(i + chunk, candidate.size()));
+
+            std::optional<FuzzFailure> f;
+            try {
+                f = replay_actions<R>(start, candidate);
+            } catch (const std::runtime_error&) {
+                // Taking those steps out made a later one impossible
+            }
+
+            if (f) {
+                failure = *f;
+                actions = std::move(candidate);
+                actions.resize(failure.steps);
+                removed = true;
+            } else {
+                i += chunk;
+            }
+        }
+
+        if (chunk > 1) {
+            chunk /= 2;
+        } else if (!removed) {
+            break;
+        }
+    }
+
+    return failure;
+}
+
+std::string action_to_text(const FuzzAction& action) {
+    switch (action.kind) {
+        case FA_Undo:
+            return "undo";
+        case FA_SafeMoves:
+            return "safe";
+        default:
+            return move_to_text(action.move);
+    }
+}
+
+FuzzAction action_from_text(std::string_view text) {
+    if (text == "undo") {
+        return FuzzAction { FA_Undo, CyclePile {} };
+    } else if (text == "safe") {
+        return FuzzAction { FA_SafeMoves, CyclePile {} };
+    } else {
+        return FuzzAction { FA_Move, move_from_text(text) };
+    }
+}
+
+std::string replay_to_text(const FuzzReplay& replay) {
+    std::string text = std::format("rules {} {} {}\n{}\n", replay.rules.draw, replay.rules.passes, (int)replay.rules.foundationReturn, replay.board);
+    for (const FuzzAction& action : replay.actions) {
+        text += action_to_text(action) + "\n";
+    }
+    return text;
+}
+
+void save_fuzz_replay(const std::string& path, const FuzzReplay& replay) {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error(std::format("Couldn't write the replay to {}", path));
+    }
+
+    out << replay_to_text(replay);
+}
+
+FuzzReplay load_fuzz_replay(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::format("Couldn't open the replay {}", path));
+    }
+
+    FuzzReplay replay;
+    std::string line;
+
+    std::getline(in, line);
+    std::istringstream rules(line);
+    std::string word;
+    int foundationReturn;
+    if (!(rules >> word >> replay.rules.draw >> replay.rules.passes >> foundationReturn) || word != "rules" || !is_supported(replay.rules)) {
+        throw std::runtime_error(std::format("{} should start with a line like \"rules 3 0 1\", not \"{}\"", path, line));
+    }
+    replay.rules.foundationReturn = foundationReturn;
+
+    std::getline(in, replay.board);
+    // Throws if it isn't a board
+    board_from_text(replay.board, replay.rules);
+
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            replay.actions.push_back(action_from_text(line));
+        }
+    }
+
+    return replay;
+}
+
+// Everything one thread needs to fuzz games
+struct FuzzWorker {
+    std::vector<FuzzAction> actions;
+    long steps = 0;
+    std::vector<std::byte> arenaBuffer = std::vector<std::byte>(GAME_ARENA_SIZE);
+    std::pmr::monotonic_buffer_resource arena { arenaBuffer.data(), arenaBuffer.size() };
+};
+
+// The first game that went wrong
+struct FoundFailure {
+    int game;
+    FuzzReplay replay;
+    FuzzFailure failure;
+};
+
+bool fuzz_rule_set(const FuzzOptions& options, const RuleSet& rules, std::vector<std::unique_ptr<FuzzWorker>>& workers) {
+    TRACE_SCOPE("fuzz_rule_set");
+
+    std::atomic<bool> failed = false;
+    std::mutex mutex;
+    std::optional<FoundFailure> found;
+
+    for (std::unique_ptr<FuzzWorker>& w : workers) {
+        w->steps = 0;
+    }
+
+    Timer timer;
+
+    with_rules(rules, [&]<typename R>() {
+        parallel_for(options.games, workers.size(), [&](int worker, int i) {
+            if (failed) {
+                return;
+            }
+
+            FuzzWorker& w = *workers[worker];
+            std::mt19937 rand(options.seed + i);
+            Board start(rules, &w.arena);
+            start.deal(rand);
+
+            std::optional<FuzzFailure> failure = fuzz_game<R>(start, rand, options.steps, w.actions, &w.arena);
+            w.steps += w.actions.size();
+
+            if (failure) {
+                std::lock_guard lock(mutex);
+                if (!found || i < found->game) {
+                    found = FoundFailure { i, FuzzReplay { rules, board_to_text(start), w.actions }, *failure };
+                }
+                failed = true;
+            }
+
+            w.arena.release();
+        });
+    });
+
+    double seconds = timer.elapsed();
+    long steps = 0;
+    for (std::unique_ptr<FuzzWorker>& w : workers) {
+        steps += w->steps;
+    }
+
+    if (!found) {
+        std::println("{}: {} games, {} steps, no disagreements ({:.2f}s, {:.0f} steps per second)",
+            describe(rules), options.games, steps, seconds, steps / seconds);
+        return true;
+    }
+
+    std::println("{}: game {} (seed {}) disagreed after {} steps:\n  {}",
+        describe(rules), found->game, options.seed + found->game, found->failure.steps, found->failure.what);
+
+    Board start = board_from_text(found->replay.board, rules);
+    FuzzFailure shrunk = with_rules(rules, [&]<typename R>() {
+        return shrink<R>(start, found->replay.actions, found->failure);
+    });
+
+    save_fuzz_replay(options.failurePath, found->replay);
+    std::println("\nshrunk to {} steps, saved to {} (play it back with `bs fuzz --replay {}`):\n{}",
+        found->replay.actions.size(), options.failurePath, options.failurePath, replay_to_text(found->replay));
+    std::println("which disagrees with:\n  {}", shrunk.what);
+
+    return false;
+}
+
+bool fuzz_rules(const FuzzOptions& options) {
+    TRACE_SCOPE("fuzz_rules");
+
+    std::vector<std::unique_ptr<FuzzWorker>> workers;
+    for (int i = 0; i < worker_count(options.threads); i++) {
+        workers.push_back(std::make_unique<FuzzWorker>());
+    }
+
+    for (const RuleSet& rules : options.ruleSets) {
+        if (!fuzz_rule_set(options, rules, workers)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool check_fuzz_replay(const FuzzReplay& replay) {
+    Board start = board_from_text(replay.board, replay.rules);
+    std::optional<FuzzFailure> failure = with_rules(replay.rules, [&]<typename R>() {
+        return replay_actions<R>(start, replay.actions);
+    });
+
+    if (!failure) {
+        std::println("{}: agreed on all {} steps", describe(replay.rules), replay.actions.size());
+        return true;
+    }
+
+    std::println("{}: disagreed after {} steps:\n  {}", describe(replay.rules), failure->steps, failure->what);
+    return false;
+}
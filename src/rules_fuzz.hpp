@@ -0,0 +1,62 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+#include "moves.hpp"
+#include "rules.hpp"
+
+// `bs fuzz`: plays lots of random games on Board and on ReferenceBoard (see rules_reference.hpp)
+// side by side, and checks after every step that they agree on which moves are legal and on what
+// the board looks like. Anything that makes the engine faster has to keep this quiet.
+//
+// The games aren't just moves. They also take moves back with undo_move, and put cards up with
+// apply_safe_moves and take them back down with undo_safe_moves, since the solver leans on all of
+// those.
+//
+// When the two disagree, the game is shrunk down to the fewest steps that still show a
+// disagreement, and saved so it can be played back with `bs fuzz --replay FILE`.
+
+struct FuzzOptions {
+    // Every rule set gets its own games
+    std::vector<RuleSet> ruleSets;
+    int games = 100000;
+    // Most steps to play in one game
+    int steps = 300;
+    // 0 means one per hardware thread
+    int threads = 0;
+    // Game i is dealt and played with seed + i
+    unsigned int seed = 0;
+    // Where to save the shrunk replay of a disagreement
+    std::string failurePath = "fuzz-failure.txt";
+};
+
+enum FuzzActionKind {
+    FA_Move,
+    FA_Undo,
+    FA_SafeMoves,
+};
+
+// One step of a fuzzed game
+struct FuzzAction {
+    FuzzActionKind kind;
+    // Only for FA_Move
+    SolitaireMove move;
+};
+
+// A position and the steps played from it. Saved as a line with the rules ("rules 3 0 1" for
+// draw 3, unlimited passes, moves from the aces allowed), a line with the board (see
+// notation.hpp), then a step per line: a move, "undo" or "safe".
+struct FuzzReplay {
+    RuleSet rules;
+    std::string board;
+    std::vector<FuzzAction> actions;
+};
+
+void save_fuzz_replay(const std::string& path, const FuzzReplay& replay);
+FuzzReplay load_fuzz_replay(const std::string& path);
+
+// Returns whether every game agreed
+bool fuzz_rules(const FuzzOptions& options);
+// Plays the replay back on both and prints where they disagree. Returns whether they agreed.
+bool check_fuzz_replay(const FuzzReplay& replay);
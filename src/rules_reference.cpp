@@ -0,0 +1,255 @@
+#include "rules_reference.hpp"
+
+#include <algorithm>
+#include <variant>
+
+ReferenceBoard::ReferenceBoard(const Board& board) :
+    stock(board.stock.begin(), board.stock.end()),
+    pile(board.pile.begin(), board.pile.end()),
+    rules(board.rules),
+    redeals(board.redeals)
+{
+    for (int i = 0; i < 7; i++) {
+        playfield[i].assign(board.playfield[i].begin(), board.playfield[i].end());
+    }
+
+    for (int i = 0; i < 4; i++) {
+        aces[i].assign(board.aces[i].begin(), board.aces[i].end());
+    }
+}
+
+bool ReferenceBoard::is_solved() const {
+    for (const std::vector<Card>& stack : playfield) {
+        for (const Card& c : stack) {
+            if (!c.upturned) {
+                return false;
+            }
+        }
+    }
+
+    return stock.empty() && pile.empty();
+}
+
+bool is_red(Suit suit) {
+    return suit == Hearts || suit == Diamonds;
+}
+
+// Kings go on empty stacks, anything else goes on a card of the other colour one higher
+bool fits_on_stack(const Card& c, const std::vector<Card>& stack) {
+    if (stack.empty()) {
+        return c.value == King;
+    }
+
+    const Card& top = stack.back();
+    return is_red(c.suit) != is_red(top.suit) && c.value + 1 == top.value;
+}
+
+// Aces go on empty piles, anything else goes on the card of its suit one lower
+bool fits_on_aces(const Card& c, const std::vector<Card>& acesPile) {
+    if (acesPile.empty()) {
+        return c.value == Ace;
+    }
+
+    const Card& top = acesPile.back();
+    return c.suit == top.suit && c.value == top.value + 1;
+}
+
+std::vector<SolitaireMove> ReferenceBoard::legal_moves() const {
+    std::vector<SolitaireMove> moves;
+    moves.reserve(32);
+
+    // The stock can be dealt from while it has cards. When it's empty, the pile can be turned
+    // back over as long as that doesn't use more passes than the rules give us.
+    if (rules.passes == 0 || !stock.empty() || redeals + 1 < rules.passes) {
+        moves.push_back(CyclePile {});
+    }
+
+    // Every card that can be picked up, and whether anything would be on top of it
+    struct Source {
+        Card card;
+        CardSource source;
+        std::pair<int, int> coord;
+        bool single;
+    };
+    std::vector<Source> sources;
+    sources.reserve(32);
+
+    if (!pile.empty()) {
+        sources.push_back({ pile.back(), CS_Pile, { 0, 0 }, true });
+    }
+
+    if (rules.foundationReturn) {
+        for (int i = 0; i < 4; i++) {
+            if (!aces[i].empty()) {
+                sources.push_back({ aces[i].back(), CS_Aces, { i, 0 }, true });
+            }
+        }
+    }
+
+    for (int i = 0; i < 7; i++) {
+        for (int j = 0; j < (int)playfield[i].size(); j++) {
+            if (playfield[i][j].upturned) {
+                sources.push_back({ playfield[i][j], CS_Playfield, { i, j }, j + 1 == (int)playfield[i].size() });
+            }
+        }
+    }
+
+    for (const Source& s : sources) {
+        for (int i = 0; i < 7; i++) {
+            bool sameStack = s.source == CS_Playfield && s.coord.first == i;
+            if (!sameStack && fits_on_stack(s.card, playfield[i])) {
+                moves.push_back(MoveToStack { .source = s.source, .fromCoord = s.coord, .toStackId = i });
+            }
+        }
+
+        // Only one card at a time goes up, and never from one aces pile to another
+        if (s.single && s.source != CS_Aces) {
+            for (int i = 0; i < 4; i++) {
+                if (fits_on_aces(s.card, aces[i])) {
+                    moves.push_back(MoveToAces { .source = s.source, .fromCoord = s.coord, .toAcesId = i });
+                }
+            }
+        }
+    }
+
+    return moves;
+}
+
+bool ReferenceBoard::is_listed(const SolitaireMove& move) const {
+    CardSource source;
+    std::pair<int, int> from;
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        source = m->source;
+        from = m->fromCoord;
+    } else if (const MoveToAces* a = std::get_if<MoveToAces>(&move)) {
+        source = a->source;
+        from = a->fromCoord;
+    } else {
+        return true;
+    }
+
+    // possible_moves never moves a king off the bottom of a stack, since moving it to another
+    // empty stack wouldn't change anything. That means it doesn't offer putting it up on the aces
+    // either, but there's nothing face down left in its stack by then, so it doesn't stop the
+    // game being won.
+    return !(source == CS_Playfield && from.second == 0 && playfield[from.first][0].value == King);
+}
+
+void ReferenceBoard::apply(const SolitaireMove& move) {
+    if (std::holds_alternative<CyclePile>(move)) {
+        if (stock.empty()) {
+            // Turn the pile over, so its bottom card is dealt first next time
+            redeals++;
+            stock.assign(pile.rbegin(), pile.rend());
+            pile.clear();
+        } else {
+            // Deal one card at a time, so the last one dealt ends up on top
+            for (int i = 0; i < rules.draw && !stock.empty(); i++) {
+                pile.push_back(stock.back());
+                stock.pop_back();
+            }
+        }
+        return;
+    }
+
+    CardSource source;
+    std::pair<int, int> from;
+    std::vector<Card>* to;
+    if (const MoveToStack* m = std::get_if<MoveToStack>(&move)) {
+        source = m->source;
+        from = m->fromCoord;
+        to = &playfield[m->toStackId];
+    } else {
+        const MoveToAces& a = std::get<MoveToAces>(move);
+        source = a.source;
+        from = a.fromCoord;
+        to = &aces[a.toAcesId];
+    }
+
+    // Pick up the card and everything on top of it
+    std::vector<Card>& stack = source == CS_Pile ? pile : source == CS_Aces ? aces[from.first] : playfield[from.first];
+    int first = source == CS_Playfield ? from.second : (int)stack.size() - 1;
+    std::vector<Card> cards(stack.begin() + first, stack.end());
+    stack.resize(first);
+
+    // Whatever was under them on the playfield gets turned over
+    if (source == CS_Playfield && !stack.empty()) {
+        stack.back().upturned = true;
+    }
+
+    to->insert(to->end(), cards.begin(), cards.end());
+}
+
+bool ReferenceBoard::is_safe_for_aces(const Card& c) const {
+    // How many cards of each suit are up
+    std::array<int, 4> up {};
+    for (const std::vector<Card>& acesPile : aces) {
+        if (!acesPile.empty()) {
+            up[acesPile.back().suit] = acesPile.back().value + 1;
+        }
+    }
+
+    if (up[c.suit] != c.value) {
+        return false;
+    }
+
+    // Aces and twos can't go on anything else that isn't up already. Anything higher is safe
+    // once both cards of the other colour that could go on it are up.
+    if (c.value <= Two) {
+        return true;
+    }
+
+    for (int s = 0; s < 4; s++) {
+        if (is_red(static_cast<Suit>(s)) != is_red(c.suit) && up[s] < c.value) {
+            return false;
+        }
+    }
+
+    // If cards can come back down from the aces, a black 4 could come down onto a red 5 so that
+    // a red 3 can go on it. So with that allowed, the other red 3 has to be up too.
+    if (rules.foundationReturn) {
+        for (int s = 0; s < 4; s++) {
+            if (s != c.suit && is_red(static_cast<Suit>(s)) == is_red(c.suit) && up[s] < c.value - 1) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<Card> ReferenceBoard::safe_cards() const {
+    std::vector<Card> cards;
+
+    for (const std::vector<Card>& stack : playfield) {
+        if (!stack.empty() && is_safe_for_aces(stack.back())) {
+            cards.push_back(stack.back());
+        }
+    }
+
+    // With draw 3 taking a card out of the pile changes what turns up on the next pass, so it's
+    // never counted as safe
+    if (rules.draw == 1 && !pile.empty() && is_safe_for_aces(pile.back())) {
+        cards.push_back(pile.back());
+    }
+
+    return cards;
+}
+
+Board ReferenceBoard::to_board() const {
+    Board board(rules);
+
+    for (int i = 0; i < 7; i++) {
+        board.playfield[i].assign(playfield[i].begin(), playfield[i].end());
+    }
+
+    for (int i = 0; i < 4; i++) {
+        board.aces[i].assign(aces[i].begin(), aces[i].end());
+    }
+
+    board.stock.assign(stock.begin(), stock.end());
+    board.pile.assign(pile.begin(), pile.end());
+    board.redeals = redeals;
+
+    return board;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include "board.hpp"
+#include "cards.hpp"
+#include "moves.hpp"
+#include "rules.hpp"
+
+// A second copy of the rules, written to be obviously right rather than fast, for the fuzzer in
+// rules_fuzz.hpp to check Board against. Nothing in here is templated or looked up in a table, and
+// nothing is undone: every check is spelled out from the values and suits, so it can be read side
+// by side with the rules. It's far too slow for playing games with.
+//
+// It keeps the same conventions as Board, so the two can be compared card for card: stacks are
+// bottom first, the top of the stock is the card dealt next, and moves address cards the same
+// way possible_moves does.
+struct ReferenceBoard {
+    explicit ReferenceBoard(const Board& board);
+
+    std::array<std::vector<Card>, 7> playfield;
+    std::array<std::vector<Card>, 4> aces;
+    std::vector<Card> stock;
+    std::vector<Card> pile;
+    RuleSet rules;
+    int redeals = 0;
+
+    bool is_solved() const;
+
+    // Every move that can be made, in no particular order
+    std::vector<SolitaireMove> legal_moves() const;
+    // Whether possible_moves should list this legal move. It leaves out kings at the bottom of a
+    // stack.
+    bool is_listed(const SolitaireMove& move) const;
+    // Makes the move, which has to be one of legal_moves()
+    void apply(const SolitaireMove& move);
+
+    // Whether the card is the next one up on the aces, and nothing could ever go on it anywhere
+    // else, which is what Board::apply_safe_moves puts up
+    bool is_safe_for_aces(const Card& c) const;
+    // The playfield tops (and with draw 1, the top of the pile) that are safe for the aces
+    std::vector<Card> safe_cards() const;
+
+    // The same position as a Board, for printing with board_to_text
+    Board to_board() const;
+};
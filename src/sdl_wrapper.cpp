@@ -1,7 +1,6 @@
 #include "sdl_wrapper.hpp"
 
 #include <SDL.h>
-#include <SDL_image.h>
 #include <format>
 #include <stdexcept>
 #include <utility>
@@ -11,11 +10,6 @@ Renderer::Renderer(int width, int height, Uint32 window_flags) {
         throw std::runtime_error(std::format("SDL failed to initialise: {}\n", SDL_GetError()));
     }
 
-    int imgFlags = IMG_INIT_PNG;
-    if( !( IMG_Init( imgFlags ) & imgFlags ) ) {
-        throw std::runtime_error(std::format("SDL_image failed to initialise: {}\n", IMG_GetError()));
-    }
-
     if (SDL_CreateWindowAndRenderer(width, height, window_flags, &window, &renderer)) {
         throw std::runtime_error(std::format("Failed to create window or renderer: {}\n", SDL_GetError()));
     }
@@ -24,7 +18,6 @@ Renderer::Renderer(int width, int height, Uint32 window_flags) {
 Renderer::~Renderer() {
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
-    IMG_Quit();
     SDL_Quit();
 }
 
@@ -38,6 +31,7 @@ void Renderer::draw_texture(const Texture& texture, int x, int y) {
     destRect.y = y;
     destRect.w = texture.getWidth();
     destRect.h = texture.getHeight();
+    drawCalls++;
     SDL_RenderCopy(renderer, texture.inner(), nullptr, &destRect);
 }
 
@@ -51,14 +45,35 @@ void Renderer::draw_texture(const Texture& texture, const std::optional<SDL_Rect
         src = &srcRect.value();
     }
 
+    drawCalls++;
     SDL_RenderCopy(renderer, texture.inner(), src, &destRect);
 }
 
+void Renderer::draw_batch(const SpriteBatch& batch) {
+    if (batch.empty()) {
+        return;
+    }
+
+    drawCalls++;
+    SDL_RenderGeometry(renderer, batch.texture->inner(), batch.vertices.data(), batch.vertices.size(),
+        batch.indices.data(), batch.indices.size());
+}
+
+void Renderer::set_title(const std::string& title) {
+    SDL_SetWindowTitle(window, title.c_str());
+}
+
 void Renderer::set_draw_colour(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
     SDL_SetRenderDrawColor(renderer, r, g, b, a);
 }
 
+void Renderer::fill_rect(const SDL_Rect& rect) {
+    drawCalls++;
+    SDL_RenderFillRect(renderer, &rect);
+}
+
 void Renderer::clear() {
+    drawCalls++;
     SDL_RenderClear(renderer);
 }
 
@@ -66,22 +81,57 @@ void Renderer::present() {
     SDL_RenderPresent(renderer);
 }
 
-Texture::Texture(Renderer& renderer, std::string path) {
-    SDL_Surface *surface = IMG_Load(path.c_str());
+std::string Renderer::driver_name() {
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(renderer, &info)) {
+        return "unknown";
+    }
+    return info.name;
+}
+
+bool Renderer::supports_targets() {
+    return SDL_RenderTargetSupported(renderer);
+}
+
+void Renderer::set_target(Texture* target) {
+    SDL_Texture* inner = target == nullptr ? nullptr : target->inner();
+
+    if (SDL_SetRenderTarget(renderer, inner)) {
+        throw std::runtime_error(std::format("Couldn't set render target: {}", SDL_GetError()));
+    }
+}
+
+Texture::Texture(Renderer& renderer, const unsigned char* pixels, int width, int height) : width(width), height(height) {
+    // SDL only reads from the pixels here, it just doesn't say so
+    SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(const_cast<unsigned char*>(pixels),
+        width, height, 32, width * 4, SDL_PIXELFORMAT_RGBA32);
 
     if (surface == nullptr) {
-        throw std::runtime_error(std::format("Couldn't load surface from path \"{}\": {}", path, IMG_GetError()));
+        throw std::runtime_error(std::format("Couldn't make a surface from pixels: {}", SDL_GetError()));
     }
 
-    width = surface->w;
-    height = surface->h;
     texture = SDL_CreateTextureFromSurface(renderer.inner(), surface);
+    SDL_FreeSurface(surface);
 
     if (texture == nullptr) {
         throw std::runtime_error(std::format("Couldn't convert surface to texture: {}", SDL_GetError()));
     }
+}
 
-    SDL_FreeSurface(surface);
+Texture::Texture(Renderer& renderer, SDL_Surface* surface) : width(surface->w), height(surface->h) {
+    texture = SDL_CreateTextureFromSurface(renderer.inner(), surface);
+
+    if (texture == nullptr) {
+        throw std::runtime_error(std::format("Couldn't convert surface to texture: {}", SDL_GetError()));
+    }
+}
+
+Texture::Texture(Renderer& renderer, int width, int height) : width(width), height(height) {
+    texture = SDL_CreateTexture(renderer.inner(), SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+    if (texture == nullptr) {
+        throw std::runtime_error(std::format("Couldn't create target texture: {}", SDL_GetError()));
+    }
 }
 
 Texture::Texture(Texture&& t) noexcept
@@ -108,3 +158,36 @@ int Texture::getWidth() const {
 int Texture::getHeight() const {
     return height;
 }
+
+void Texture::set_colour_mod(Uint8 r, Uint8 g, Uint8 b) {
+    SDL_SetTextureColorMod(texture, r, g, b);
+}
+
+void SpriteBatch::add(const SDL_Rect& src, const SDL_FRect& dest) {
+    float width = texture->getWidth();
+    float height = texture->getHeight();
+    float u0 = src.x / width;
+    float v0 = src.y / height;
+    float u1 = (src.x + src.w) / width;
+    float v1 = (src.y + src.h) / height;
+
+    SDL_Color white { 0xFF, 0xFF, 0xFF, 0xFF };
+    int first = vertices.size();
+    vertices.push_back({ { dest.x, dest.y }, white, { u0, v0 } });
+    vertices.push_back({ { dest.x + dest.w, dest.y }, white, { u1, v0 } });
+    vertices.push_back({ { dest.x + dest.w, dest.y + dest.h }, white, { u1, v1 } });
+    vertices.push_back({ { dest.x, dest.y + dest.h }, white, { u0, v1 } });
+
+    for (int i : { 0, 1, 2, 2, 3, 0 }) {
+        indices.push_back(first + i);
+    }
+}
+
+void SpriteBatch::add(const SDL_FRect& dest) {
+    add(SDL_Rect { 0, 0, texture->getWidth(), texture->getHeight() }, dest);
+}
+
+void SpriteBatch::clear() {
+    vertices.clear();
+    indices.clear();
+}
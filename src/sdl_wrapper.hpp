@@ -1,11 +1,14 @@
 #pragma once
 
 #include <SDL.h>
+#include <cstdint>
 #include <optional>
 #include <string>
+#include <vector>
 
 struct Renderer;
 struct Texture;
+struct SpriteBatch;
 
 /// Wrapper for the renderer and window.
 struct Renderer {
@@ -19,23 +22,45 @@ struct Renderer {
     SDL_Renderer* inner() { return renderer; }
 
     void set_draw_colour(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
+    void fill_rect(const SDL_Rect& rect);
     void clear();
     void present();
 
+    /// How many times we've asked SDL to draw something (clears, fills and copies) since we were made
+    uint64_t draw_calls() const { return drawCalls; }
+    /// The name of the SDL render driver we ended up with, e.g. "opengl" or "software"
+    std::string driver_name();
+
+    /// Whether textures can be used as render targets (see Texture's target constructor)
+    bool supports_targets();
+    /// Redirect all drawing into the given target texture. Pass nullptr to draw to the window again.
+    void set_target(Texture* target);
+
     /// Draw the texture directly onto the screen at a certain position
     void draw_texture(const Texture& texture, int x, int y);
     /// Draw the texture with full control over src and dst (See SDL_RenderCopy)
     void draw_texture(const Texture& texture, const std::optional<SDL_Rect>& src, const SDL_Rect& dest);
+    /// Draw everything in the batch, in one go
+    void draw_batch(const SpriteBatch& batch);
+
+    void set_title(const std::string& title);
 
 private:
     SDL_Renderer* renderer;
     SDL_Window* window;
+    uint64_t drawCalls = 0;
 };
 
 /// Wrapper for an sdl texture on the GPU
 struct Texture {
     Texture() : texture(nullptr) {}
-    Texture(Renderer& renderer, std::string path);
+    // Copies raw pixels (in SDL_PIXELFORMAT_RGBA32, like the ones assets/embed_png.py makes)
+    // onto the GPU
+    Texture(Renderer& renderer, const unsigned char* pixels, int width, int height);
+    // Copies the surface onto the GPU. The surface isn't freed
+    Texture(Renderer& renderer, SDL_Surface* surface);
+    // Creates a blank texture that can be drawn into with Renderer::set_target
+    Texture(Renderer& renderer, int width, int height);
     // We can't copy an SDL_Texture, only move. If you want to share a Texture around use a
     // shared_ptr.
     Texture(const Texture& t) = delete;
@@ -51,6 +76,9 @@ struct Texture {
     // These getters return the width and height of the entire texture in pixels
     int getWidth() const;
     int getHeight() const;
+
+    /// Multiplies the colour of everything drawn from this texture (See SDL_SetTextureColorMod)
+    void set_colour_mod(Uint8 r, Uint8 g, Uint8 b);
     
 private:
     SDL_Texture* texture;
@@ -58,3 +86,25 @@ private:
     int width;
     int height;
 };
+
+/// Sprites from one texture, to be drawn with a single draw call (rather than one SDL_RenderCopy
+/// each). Keep one around and clear it, so the vertex storage gets reused.
+struct SpriteBatch {
+    SpriteBatch(const Texture& texture) : texture(&texture) {}
+
+    /// Queue the src part of the texture to be drawn at dest. Unlike SDL_Rects, dest can be a
+    /// fraction of a pixel, so things can be scaled down without the gaps between them wobbling.
+    void add(const SDL_Rect& src, const SDL_FRect& dest);
+    /// Queue the whole texture to be drawn at dest
+    void add(const SDL_FRect& dest);
+    void clear();
+
+    bool empty() const { return indices.empty(); }
+
+private:
+    friend struct Renderer;
+
+    const Texture* texture;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+};
@@ -0,0 +1,103 @@
+#ifdef BS_TRACING
+
+#include "trace.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <print>
+#include <vector>
+
+namespace trace {
+
+// Per thread, we only keep the most recent events. A 10000 game benchmark produces far more
+// events than anyone wants to look at anyway
+const size_t RING_SIZE = 1 << 16;
+
+struct Event {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct Ring {
+    int threadId;
+    // Total number of events ever recorded, the write position is this mod RING_SIZE
+    size_t count = 0;
+    std::array<Event, RING_SIZE> events;
+};
+
+const auto START = std::chrono::steady_clock::now();
+
+// Rings are owned by this list rather than by their threads, so that events from worker threads
+// that have already finished still get exported
+std::mutex ringsMutex;
+std::vector<std::unique_ptr<Ring>> rings;
+
+Ring& thread_ring() {
+    thread_local Ring* ring = [] {
+        std::lock_guard lock(ringsMutex);
+        rings.push_back(std::make_unique<Ring>());
+        rings.back()->threadId = rings.size();
+        return rings.back().get();
+    }();
+
+    return *ring;
+}
+
+uint64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - START).count();
+}
+
+void record(const char* name, uint64_t start, uint64_t end) {
+    Ring& ring = thread_ring();
+    ring.events[ring.count % RING_SIZE] = Event { name, start, end };
+    ring.count++;
+}
+
+void write_chrome_json(const std::string& path) {
+    std::lock_guard lock(ringsMutex);
+    std::ofstream out(path);
+
+    if (!out) {
+        std::println(stderr, "Couldn't write trace to \"{}\"", path);
+        return;
+    }
+
+    // See the "Trace Event Format" document for what all this means. We use complete ("X")
+    // events with microsecond timestamps.
+    out << "{\"traceEvents\":[";
+    bool first = true;
+
+    for (const auto& ring : rings) {
+        size_t begin = ring->count > RING_SIZE ? ring->count - RING_SIZE : 0;
+
+        for (size_t i = begin; i < ring->count; i++) {
+            const Event& e = ring->events[i % RING_SIZE];
+
+            out << (first ? "\n" : ",\n");
+            out << std::format(
+                "{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                e.name, ring->threadId, e.start / 1e3, (e.end - e.start) / 1e3
+            );
+            first = false;
+        }
+    }
+
+    out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+// Writes the trace when the program exits
+struct Exporter {
+    ~Exporter() {
+        const char* path = std::getenv("BS_TRACE_FILE");
+        write_chrome_json(path ? path : "bs_trace.json");
+    }
+} exporter;
+
+}
+
+#endif
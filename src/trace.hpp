@@ -0,0 +1,51 @@
+#pragma once
+
+// Lightweight scoped tracing, so we can see where a frame or an ai turn spends its time without
+// reaching for an external profiler.
+//
+// Put TRACE_SCOPE("name") at the top of a block and the time spent in that block gets recorded
+// into a ring buffer belonging to the current thread. On exit, everything is written out as a
+// Chrome trace (open it in chrome://tracing or ui.perfetto.dev). The path comes from the
+// BS_TRACE_FILE environment variable and defaults to "bs_trace.json".
+//
+// This is only compiled in when building with `meson configure -Dtracing=true`. Otherwise the
+// macro expands to nothing and none of this costs anything.
+
+#ifdef BS_TRACING
+
+#include <cstdint>
+#include <string>
+
+namespace trace {
+
+// Nanoseconds since the program started
+uint64_t now();
+
+// Adds a finished event to the current thread's ring buffer. name must be a string literal
+// (or otherwise live until the program exits), since we only store the pointer.
+void record(const char* name, uint64_t start, uint64_t end);
+
+void write_chrome_json(const std::string& path);
+
+struct Scope {
+    explicit Scope(const char* name) : name(name), start(now()) {}
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+    ~Scope() { record(name, start, now()); }
+
+private:
+    const char* name;
+    uint64_t start;
+};
+
+}
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) ::trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
+
+#else
+
+#define TRACE_SCOPE(name) ((void)0)
+
+#endif
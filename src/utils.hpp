@@ -1,4 +1,7 @@
+#pragma once
+
 #include <chrono> // for std::chrono functions
+#include <utility>
 
 class Timer
 {
@@ -20,3 +23,16 @@ public:
 		return std::chrono::duration_cast<Second>(Clock::now() - m_beg).count();
 	}
 };
+
+// Calls f when it goes out of scope, however that happens
+template <typename F>
+class OnExit {
+public:
+	explicit OnExit(F f) : f(std::move(f)) {}
+	OnExit(const OnExit&) = delete;
+	OnExit& operator=(const OnExit&) = delete;
+	~OnExit() { f(); }
+
+private:
+	F f;
+};
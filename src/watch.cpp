@@ -0,0 +1,269 @@
+#include "watch.hpp"
+#include "layout.hpp"
+#include "trace.hpp"
+#include "ai/benchmark.hpp"
+#include "assets/cards_png.hpp"
+#include "assets/outline_png.hpp"
+#include <algorithm>
+#include <format>
+
+// The biggest the window gets. Boards are scaled down until the grid fits.
+const int MAX_WALL_WIDTH = 1800;
+const int MAX_WALL_HEIGHT = 1000;
+const int CELL_GAP = 4;
+
+// How much of each frame all the ais get to think in, between them
+const double WALL_THINK_TIME = 1. / 120.;
+// How long a finished game stays up before the next one is dealt in its place
+const double FINISHED_PAUSE = 1.5;
+
+float wall_scale(const WatchOptions& options) {
+    float scaleX = static_cast<float>(MAX_WALL_WIDTH - CELL_GAP * (options.columns + 1)) / (options.columns * WINDOW_WIDTH);
+    float scaleY = static_cast<float>(MAX_WALL_HEIGHT - CELL_GAP * (options.rows + 1)) / (options.rows * WINDOW_HEIGHT);
+    return std::min({ scaleX, scaleY, 1.0f });
+}
+
+Watch::Watch(const WatchOptions& options, const AiFactory& makeAi) :
+    options(options),
+    scale(wall_scale(options)),
+    cellWidth(static_cast<int>(WINDOW_WIDTH * scale)),
+    cellHeight(static_cast<int>(WINDOW_HEIGHT * scale)),
+    renderer(
+        options.columns * (cellWidth + CELL_GAP) + CELL_GAP,
+        options.rows * (cellHeight + CELL_GAP) + CELL_GAP,
+        SDL_WINDOW_SHOWN),
+    cardTexture(renderer, CARDS_PIXELS, CARDS_WIDTH, CARDS_HEIGHT),
+    cardOutline(renderer, OUTLINE_PIXELS, OUTLINE_WIDTH, OUTLINE_HEIGHT),
+    cards(cardTexture),
+    outlines(cardOutline),
+    nextSeed(options.seed)
+{
+    int count = options.columns * options.rows;
+    games.reserve(count);
+
+    for (int i = 0; i < count; i++) {
+        games.emplace_back(options.rules, makeAi());
+
+        if (renderer.supports_targets()) {
+            games.back().layer = Texture(renderer, cellWidth, cellHeight);
+        }
+
+        deal(games.back());
+    }
+
+    renderer.set_title(std::format("bs watch: {} games ({})", count, describe(options.rules)));
+}
+
+void Watch::run() {
+    bool exiting = false;
+    SDL_Event e;
+
+    while (!exiting) {
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) {
+                exiting = true;
+            } else if (e.type == SDL_RENDER_TARGETS_RESET) {
+                // The contents of target textures are lost when this happens
+                for (WatchedGame& game : games) {
+                    game.dirty = true;
+                }
+            }
+        }
+
+        double thinkTime = WALL_THINK_TIME / games.size();
+        for (WatchedGame& game : games) {
+            step(game, thinkTime);
+        }
+
+        render();
+    }
+}
+
+void Watch::deal(WatchedGame& game) {
+    game.board.deal(nextSeed++);
+    if (options.safeMoves) {
+        game.board.apply_safe_moves();
+    }
+    game.ai->forget();
+    game.thinking.reset();
+    game.moveTimer.reset();
+    game.turns = 0;
+    game.finished.reset();
+    game.won = false;
+    game.dirty = true;
+}
+
+void Watch::step(WatchedGame& game, double thinkTime) {
+    TRACE_SCOPE("watch_step");
+
+    if (game.finished) {
+        if (game.finished->elapsed() >= FINISHED_PAUSE) {
+            deal(game);
+        }
+        return;
+    }
+
+    if (!game.thinking) {
+        game.thinking = game.ai->think(game.board);
+    }
+
+    Timer thinkTimer;
+    while (thinkTimer.elapsed() < thinkTime && game.thinking->resume()) {}
+
+    // Same as Game::run_ai, the ai keeps thinking until it's done or it's time to move
+    bool timeToMove = game.moveTimer.elapsed() >= 1. / options.movesPerSecond;
+    if (!timeToMove || (!game.thinking->done() && !game.thinking->best())) {
+        return;
+    }
+
+    std::optional<SolitaireMove> move = game.thinking->best();
+    game.thinking.reset();
+    game.moveTimer.reset();
+
+    if (!move) {
+        finish(game, false);
+        return;
+    }
+
+    game.board.apply_move(*move);
+    if (options.safeMoves) {
+        game.board.apply_safe_moves();
+    }
+    game.turns++;
+    game.dirty = true;
+
+    if (game.board.is_solved()) {
+        finish(game, true);
+    } else if (game.turns >= MAX_TURNS) {
+        finish(game, false);
+    }
+}
+
+void Watch::finish(WatchedGame& game, bool won) {
+    game.finished = Timer();
+    game.won = won;
+    // So the dimming shows up
+    game.dirty = true;
+
+    gamesFinished++;
+    gamesWon += won;
+
+    renderer.set_title(std::format("bs watch: {} games ({}), {}/{} won ({:.1f}%)",
+        games.size(), describe(options.rules), gamesWon, gamesFinished, 100.0 * gamesWon / gamesFinished));
+}
+
+SDL_Rect Watch::cell_rect(int i) const {
+    int column = i % options.columns;
+    int row = i / options.columns;
+    return SDL_Rect {
+        CELL_GAP + column * (cellWidth + CELL_GAP),
+        CELL_GAP + row * (cellHeight + CELL_GAP),
+        cellWidth,
+        cellHeight,
+    };
+}
+
+void Watch::render() {
+    TRACE_SCOPE("watch_render");
+
+    bool useLayers = games.front().layer.inner() != nullptr;
+
+    // Every board that changed gets redrawn into its layer, in two draw calls
+    if (useLayers) {
+        for (WatchedGame& game : games) {
+            if (!game.dirty) {
+                continue;
+            }
+
+            renderer.set_target(&game.layer);
+            renderer.set_draw_colour(0x34, 0xC9, 0x70, 0xFF);
+            renderer.clear();
+
+            cards.clear();
+            outlines.clear();
+            batch_board(game.board, 0, 0);
+            renderer.draw_batch(outlines);
+            renderer.draw_batch(cards);
+
+            renderer.set_target(nullptr);
+            game.dirty = false;
+        }
+    }
+
+    renderer.set_draw_colour(0x20, 0x20, 0x20, 0xFF);
+    renderer.clear();
+
+    if (useLayers) {
+        for (size_t i = 0; i < games.size(); i++) {
+            WatchedGame& game = games[i];
+            // Lost games are greyed out until they get replaced
+            Uint8 shade = game.finished && !game.won ? 0x70 : 0xFF;
+            game.layer.set_colour_mod(shade, shade, shade);
+            renderer.draw_texture(game.layer, std::nullopt, cell_rect(i));
+        }
+    } else {
+        // No render targets, so every board gets drawn every frame. Still only two draw calls
+        // for the cards, since the batches can take all the boards at once.
+        cards.clear();
+        outlines.clear();
+        renderer.set_draw_colour(0x34, 0xC9, 0x70, 0xFF);
+
+        for (size_t i = 0; i < games.size(); i++) {
+            SDL_Rect cell = cell_rect(i);
+            renderer.fill_rect(cell);
+            batch_board(games[i].board, cell.x, cell.y);
+        }
+
+        renderer.draw_batch(outlines);
+        renderer.draw_batch(cards);
+    }
+
+    renderer.present();
+}
+
+void Watch::batch_board(const Board& board, float x, float y) {
+    auto at = [&](int cardX, int cardY) {
+        return SDL_FRect {
+            x + cardX * scale,
+            y + cardY * scale,
+            CARD_SPRITE_WIDTH * CARD_UPSCALE * scale,
+            CARD_SPRITE_HEIGHT * CARD_UPSCALE * scale,
+        };
+    };
+
+    // Laid out the same as Game::render_board, without anything being held
+    for (int i = 0; i < 7; i++) {
+        int cardX = PLAYFIELD_START_X + i * PLAYFIELD_CARD_DX;
+        int cardY = PLAYFIELD_START_Y;
+
+        for (const Card& c : board.playfield.at(i)) {
+            if (c.upturned) {
+                cards.add(CARD_SPRITE_RECTS[c.index()], at(cardX, cardY));
+                cardY += PLAYFIELD_UP_CARD_DY;
+            } else {
+                cards.add(CARD_SPRITE_RECTS[CARD_BACK_SPRITE], at(cardX, cardY));
+                cardY += PLAYFIELD_DOWN_CARD_DY;
+            }
+        }
+    }
+
+    if (!board.stock.empty()) {
+        cards.add(CARD_SPRITE_RECTS[CARD_BACK_SPRITE], at(STOCK_X, STOCK_PILE_Y));
+    } else {
+        outlines.add(at(STOCK_X, STOCK_PILE_Y));
+    }
+
+    int pileX = PILE_X;
+    for (int i = std::min((int)board.pile.size(), 3); i > 0; i--) {
+        cards.add(CARD_SPRITE_RECTS[board.pile.at(board.pile.size() - i).index()], at(pileX, STOCK_PILE_Y));
+        pileX += PILE_DX;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (board.aces.at(i).empty()) {
+            outlines.add(at(ACES_X + i * ACES_DX, STOCK_PILE_Y));
+        } else {
+            cards.add(CARD_SPRITE_RECTS[board.aces.at(i).back().index()], at(ACES_X + i * ACES_DX, STOCK_PILE_Y));
+        }
+    }
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <vector>
+#include "sdl_wrapper.hpp"
+#include "ai/factory.hpp"
+#include "ai/thinking.hpp"
+#include "board.hpp"
+#include "utils.hpp"
+
+// `bs watch`: a wall of ai games, all playing at once in one window, for eyeballing how an ai
+// plays without sitting through one game at a time.
+
+struct WatchOptions {
+    RuleSet rules;
+    int columns = 4;
+    int rows = 4;
+    // How often each game makes a move (if its ai has decided by then)
+    double movesPerSecond = 10;
+    // Games are dealt with seed, seed + 1, ... in the order they start
+    unsigned int seed = 0;
+    // Make the safe moves (see Board::apply_safe_moves) for the ais after every move, like the
+    // benchmark does with the same option
+    bool safeMoves = false;
+};
+
+struct WatchedGame {
+    WatchedGame(RuleSet rules, std::unique_ptr<SolitaireAI> ai) : board(rules), ai(std::move(ai)) {}
+
+    Board board;
+    std::unique_ptr<SolitaireAI> ai;
+    std::optional<Thinking> thinking;
+    // Time since the last move
+    Timer moveTimer;
+    int turns = 0;
+    // How long ago the game ended, if it has, and whether it was won
+    std::optional<Timer> finished;
+    bool won = false;
+
+    // This game's cell of the wall, only redrawn when dirty
+    Texture layer;
+    bool dirty = true;
+};
+
+struct Watch {
+    Watch(const WatchOptions& options, const AiFactory& makeAi);
+
+    // Runs until the window is closed
+    void run();
+
+private:
+    WatchOptions options;
+
+    // How much the boards are shrunk to fit, and the size of each cell of the grid
+    float scale;
+    int cellWidth;
+    int cellHeight;
+
+    Renderer renderer;
+
+    Texture cardTexture;
+    Texture cardOutline;
+    SpriteBatch cards;
+    SpriteBatch outlines;
+
+    std::vector<WatchedGame> games;
+    unsigned int nextSeed;
+    int gamesFinished = 0;
+    int gamesWon = 0;
+
+    void deal(WatchedGame& game);
+    // Lets the game's ai think for up to thinkTime, and moves if it's time to
+    void step(WatchedGame& game, double thinkTime);
+    void finish(WatchedGame& game, bool won);
+
+    void render();
+    // Queues the board's sprites into the batches, with its top left corner at (x, y)
+    void batch_board(const Board& board, float x, float y);
+    SDL_Rect cell_rect(int i) const;
+};